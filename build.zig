@@ -4,22 +4,35 @@ const exe_name = "firmware";
 
 const c_src: []const []const u8 = &.{
     "main.c",
+    "hal/dma.c",
     "hal/gpio.c",
     "hal/startup.c",
     "hal/systick.c",
     "hal/uart.c",
+    "rtos/active.c",
+    "rtos/critical.c",
+    "rtos/event.c",
+    "rtos/hsm.c",
+    "rtos/queue.c",
     "rtos/thread.c",
+    "rtos/timer.c",
+    "rtos/trace.c",
+    "rtos/work.c",
     "utils/dbc_assert.c",
     "utils/debug.c",
     "utils/endian.c",
+    "utils/pool.c",
+    "utils/spsc.c",
     "utils/cbuf.c",
     "app/action.c",
     "app/apid_map.c",
     "app/frame_buffer.c",
+    "app/housekeeping.c",
     "app/kiss_frame.c",
     "app/parameter.c",
     "app/spacepacket.c",
     "app/telemetry.c",
+    "app/trace.c",
 };
 
 const c_flags: []const []const u8 = &.{
@@ -30,6 +43,8 @@ const c_flags: []const []const u8 = &.{
     "-Wdouble-promotion",
     "-fno-common",
     "-Wconversion",
+    // No stack frame may be larger than the stack guard (RTOS_STACK_GUARD_SIZE in rtos/thread.h)
+    "-Werror=frame-larger-than=256",
     "-g3",
     "-Os", // Important!
 };
@@ -2,6 +2,6 @@
 #define APP_CONFIG_H_
 
 #define SPACEPACKET_CONFIG_MIN_APID (0)
-#define SPACEPACKET_CONFIG_MAX_APID (3)
+#define SPACEPACKET_CONFIG_MAX_APID (4)
 
 #endif /* APP_CONFIG_H_ */
@@ -1,23 +1,49 @@
-
 #ifndef APP_FRAME_BUFFER_H_
 #define APP_FRAME_BUFFER_H_
 
-#include "utils/cbuf.h"
+#include "rtos/active.h"
+#include "rtos/event.h"
+#include "rtos/work.h"
+#include "utils/pool.h"
 #include "utils/status.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
-void frame_buffer_init(void);
+#define FRAME_BUFFER_COUNT (4)
+#define FRAME_BUFFER_SIZE  (256)
+
+/* A chunk of received (KISS encoded) data, a pooled event posted to the reader */
+typedef struct {
+    rtos_event_t super;
+    size_t size;
+    uint8_t data[FRAME_BUFFER_SIZE];
+} frame_t;
+
+/* Initialise the frames, which are posted to reader as sig events */
+void frame_buffer_init(rtos_active_t *const reader, uint16_t const sig);
+
+/* Get an empty frame to fill, blocking for at most ticks until one is freed */
+status_t frame_buffer_alloc(frame_t **const frame, uint32_t const ticks);
+
+/* Submit work whenever a frame is freed, so a writer that found none free can retry without
+ * blocking. NULL to disable */
+void frame_buffer_notify(rtos_work_t *const work);
+
+/* Return a frame that wasn't written, written frames are freed once the reader has handled them */
+void frame_buffer_free(frame_t *const frame);
 
-status_t frame_buffer_read(cbuf_t *const cbuf);
+/* Post a filled frame to the reader, ownership passes with the pointer (the frame is freed if the
+ * reader's queue is full) */
+status_t frame_buffer_write(frame_t *const frame);
 
-status_t frame_buffer_write(size_t const size, uint8_t const buf[size]);
+/* Pool the frames are allocated from, for usage telemetry */
+pool_t const *frame_buffer_pool(void);
 
 /* Telemetry Handlers */
-status_t frame_buffer_read_error_count(size_t *const size, uint8_t *const output);
-status_t frame_buffer_read_last_status(size_t *const size, uint8_t *const output);
+status_t frame_buffer_free_min(size_t *const size, uint8_t *const output);
 status_t frame_buffer_write_error_count(size_t *const size, uint8_t *const output);
 status_t frame_buffer_write_last_status(size_t *const size, uint8_t *const output);
+status_t frame_buffer_alloc_fail_count(size_t *const size, uint8_t *const output);
 
 #endif /* APP_FRAME_BUFFER_H_ */
@@ -0,0 +1,97 @@
+#ifndef APP_HOUSEKEEPING_H_
+#define APP_HOUSEKEEPING_H_
+
+#include "rtos/active.h"
+#include "rtos/thread.h"
+#include "rtos/timer.h"
+#include "utils/pool.h"
+#include "utils/status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Telemetry Handlers */
+status_t housekeeping_uart1_tx_pending(size_t *const size, uint8_t *const output);
+status_t housekeeping_uart2_tx_pending(size_t *const size, uint8_t *const output);
+status_t housekeeping_uart1_rx_overruns(size_t *const size, uint8_t *const output);
+
+/* CPU load over the last load window, in hundredths of a percent */
+status_t housekeeping_cpu_load(size_t *const size, uint8_t *const output);
+
+/* Longest rtos critical section, in cpu cycles */
+status_t housekeeping_critical_max_cycles(size_t *const size, uint8_t *const output);
+
+/* Load of a single thread, wrap in a telemetry handler per thread */
+status_t housekeeping_thread_load(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Release jitter of a periodic thread in cpu cycles, wrap in a telemetry handler per thread */
+status_t housekeeping_thread_jitter(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Periods overrun by a periodic thread, wrap in a telemetry handler per thread */
+status_t housekeeping_thread_overruns(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Expiry to callback jitter of a timer in cpu cycles, wrap in a telemetry handler per timer */
+status_t housekeeping_timer_jitter(
+    rtos_timer_t const *const timer,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Periods overrun by a periodic timer, wrap in a telemetry handler per timer */
+status_t housekeeping_timer_overruns(
+    rtos_timer_t const *const timer,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Shortest/longest activation response time of a thread in cpu cycles, wrap in a telemetry
+ * handler per thread */
+status_t housekeeping_thread_response_min(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+status_t housekeeping_thread_response_max(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Activations of a thread that missed their deadline, wrap in a telemetry handler per thread */
+status_t housekeeping_thread_deadline_misses(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Response time histogram of a thread, RTOS_RESPONSE_BUCKETS u32 counts (see rtos/thread.h),
+ * wrap in a telemetry handler per thread */
+status_t housekeeping_thread_response_histogram(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Stack high-water mark of a single thread in bytes, wrap in a telemetry handler per thread */
+status_t housekeeping_thread_stack_used(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Event queue high-water mark of an active object, wrap in a telemetry handler per object */
+status_t housekeeping_active_queue_max(
+    rtos_active_t const *const active,
+    size_t *const size,
+    uint8_t *const output);
+
+/* Usage of a block pool as four u32s: blocks, in use, high-water mark and failed allocations,
+ * wrap in a telemetry handler per pool */
+status_t housekeeping_pool_usage(
+    pool_t const *const pool,
+    size_t *const size,
+    uint8_t *const output);
+
+#endif /* APP_HOUSEKEEPING_H_ */
@@ -1,9 +1,8 @@
 #ifndef APP_KISS_FRAME_H_
 #define APP_KISS_FRAME_H_
 
-#include "utils/cbuf.h"
-
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define KISS_FEND  (0xC0U)
@@ -11,7 +10,20 @@
 #define KISS_TFEND (0xDCU)
 #define KISS_TFESC (0xDDU)
 
-bool kiss_frame_unpack(cbuf_t *const cbuf, size_t *const count, uint8_t *const output);
+/* Largest decoded frame, longer frames are discarded */
+#define KISS_FRAME_MAX_SIZE (1024U)
+
+/* Decode from a linear buffer starting at *consumed, which is advanced past the decoded bytes.
+ * Returns true once a whole frame has been decoded into output, decoding can then be resumed from
+ * *consumed for the next frame. count and frame_esc hold the partly decoded frame between calls,
+ * so a frame can span several buffers, clear both to start a new frame */
+bool kiss_frame_unpack_buf(
+    size_t const input_size,
+    uint8_t const input[input_size],
+    size_t *const consumed,
+    size_t *const count,
+    uint8_t *const output,
+    bool *const frame_esc);
 
 void kiss_frame_pack(
     size_t const input_size,
@@ -13,7 +13,7 @@
 #define SPACEPACKET_SEC_HDR_DISABLED (0)
 #define SPACEPACKET_SEC_HDR_ENABLED  (1)
 #define SPACEPACKET_HDR_SIZE         (6)
-#define SPACEPACKET_DATA_MAX_SIZE    (6)
+#define SPACEPACKET_DATA_MAX_SIZE    (64)
 
 #define SPACEPACKET_SEQ_FLAGS_CONTINUATION (0x0)
 #define SPACEPACKET_SEQ_FLAGS_FIRST        (0x1)
@@ -8,6 +8,11 @@
 
 typedef status_t (*telemetry_handler_t)(size_t *const, uint8_t *const);
 status_t telemetry_register(uint8_t id, telemetry_handler_t handler);
+
+/* Handler for an id whose telemetry has been removed, so ids are never reused with a different
+ * meaning. Always fails with TELEMETRY_STATUS_RETIRED_TELEMETRY_ID */
+status_t telemetry_retired(size_t *const size, uint8_t *const output);
+
 status_t telemetry_handler(
     size_t input_size,
     uint8_t const *const input_buffer,
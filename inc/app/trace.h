@@ -0,0 +1,23 @@
+#ifndef APP_TRACE_H_
+#define APP_TRACE_H_
+
+#include "utils/status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Trace download commands, the first byte of the packet data */
+#define TRACE_CMD_STOP  (0) /* Stop recording, returns the u32 count of recorded events */
+#define TRACE_CMD_START (1) /* Resume recording */
+#define TRACE_CMD_READ  (2) /* Read the record at the following u32 index, see trace_handler */
+
+/* Download the rtos trace buffer. Stop the recorder, read the records from
+ * max(0, count - RTOS_TRACE_SIZE) up to count - 1, then start it again. A record is returned as
+ * the u32 cycle counter, u8 event, u8 thread id and u16 argument (network byte order) */
+status_t trace_handler(
+    size_t input_size,
+    uint8_t const *const input_buffer,
+    size_t *const output_size,
+    uint8_t *const output_buffer);
+
+#endif /* APP_TRACE_H_ */
@@ -0,0 +1,59 @@
+#ifndef DMA_H_
+#define DMA_H_
+
+#include "hal/pinutils.h"
+
+#include <stdint.h>
+
+typedef struct dma_stream {
+    volatile uint32_t CR;
+    volatile uint32_t NDTR;
+    volatile uint32_t PAR;
+    volatile uint32_t M0AR;
+    volatile uint32_t M1AR;
+    volatile uint32_t FCR;
+} dma_stream_t;
+
+typedef struct dma {
+    volatile uint32_t LISR;
+    volatile uint32_t HISR;
+    volatile uint32_t LIFCR;
+    volatile uint32_t HIFCR;
+    dma_stream_t S[8];
+} dma_t;
+
+#define DMA1 ((dma_t *)0x40026000)
+#define DMA2 ((dma_t *)0x40026400)
+
+/* Stream configuration register (SxCR) bits */
+#define DMA_SXCR_EN         BIT(0)
+#define DMA_SXCR_TEIE       BIT(2)
+#define DMA_SXCR_HTIE       BIT(3)
+#define DMA_SXCR_TCIE       BIT(4)
+#define DMA_SXCR_DIR_P2M    (0UL << 6)
+#define DMA_SXCR_DIR_M2P    (1UL << 6)
+#define DMA_SXCR_CIRC       BIT(8)
+#define DMA_SXCR_MINC       BIT(10)
+#define DMA_SXCR_CHSEL(ch)  (((uint32_t)(ch) & 0x7U) << 25)
+
+/* Stream interrupt flags, normalised to the bit positions of stream 0 */
+#define DMA_FLAG_FE  BIT(0)
+#define DMA_FLAG_DME BIT(2)
+#define DMA_FLAG_TE  BIT(3)
+#define DMA_FLAG_HT  BIT(4)
+#define DMA_FLAG_TC  BIT(5)
+#define DMA_FLAG_ALL (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE | DMA_FLAG_HT | DMA_FLAG_TC)
+
+/* Enable the AHB1 clock for a dma controller */
+void dma_clock_enable(dma_t *const dma);
+
+/* Disable a stream and wait for any ongoing transfer to stop */
+void dma_stream_disable(dma_t *const dma, uint8_t const stream);
+
+/* Get the interrupt flags (DMA_FLAG_*) of a stream */
+uint32_t dma_flags_get(dma_t const *const dma, uint8_t const stream);
+
+/* Clear the interrupt flags (DMA_FLAG_*) of a stream */
+void dma_flags_clear(dma_t *const dma, uint8_t const stream, uint32_t const flags);
+
+#endif /* DMA_H_ */
@@ -27,6 +27,11 @@ typedef enum {
 /* ------------------- Specific STM32 Interrupt Numbers  ------------------ */
 
 /* Selected STM32F411xE IRQn values */
+  DMA1_Stream6_IRQn = 17,
+  DMA2_Stream1_IRQn = 57,
+  DMA2_Stream5_IRQn = 68,
+  DMA2_Stream6_IRQn = 69,
+  DMA2_Stream7_IRQn = 70,
   USART1_IRQn = 37,
   USART2_IRQn = 38,
   USART6_IRQn = 71,
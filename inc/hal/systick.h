@@ -14,6 +14,12 @@ typedef struct systick {
 #define SYSTICK    ((systick_t *)0xe000e010)
 #define CLOCK_FREQ (16000000) /* HSI (internal) clock for black pill is 16MHz */
 
+/* Stop the tick while the rtos is idle, sleeping until the next thread wakes up (or an interrupt
+ * fires). Disabled by default as WFI may not be supported by the emulator */
+#ifndef SYSTICK_TICKLESS
+#define SYSTICK_TICKLESS (0)
+#endif
+
 void systick_init(uint32_t const ticks);
 uint32_t systick_get_ticks(void);
 bool systick_timer_expired(uint32_t *const timer, uint32_t const period, uint32_t const now);
@@ -1,7 +1,9 @@
 #ifndef UART_H_
 #define UART_H_
 
-#include "utils/cbuf.h"
+#include "rtos/work.h"
+#include "utils/spsc.h"
+#include "utils/status.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -22,6 +24,33 @@ typedef enum uart_id {
     UART6 = 2
 } uart_id_t;
 
+/* Receive ring and transmit queue sizes in bytes (powers of two). UART1 carries the spacepacket
+ * link so its receive ring absorbs bursts, UART2 is the debug output and receives little */
+#ifndef UART1_RX_SIZE
+#define UART1_RX_SIZE (2048U)
+#endif
+#ifndef UART1_TX_SIZE
+#define UART1_TX_SIZE (256U)
+#endif
+#ifndef UART2_RX_SIZE
+#define UART2_RX_SIZE (64U)
+#endif
+#ifndef UART2_TX_SIZE
+#define UART2_TX_SIZE (1024U)
+#endif
+#ifndef UART6_RX_SIZE
+#define UART6_RX_SIZE (64U)
+#endif
+#ifndef UART6_TX_SIZE
+#define UART6_TX_SIZE (64U)
+#endif
+
+/* Number of async buffers that can be queued for transmission on each uart */
+#define UART_TX_DESC_COUNT (4)
+
+/* Called from the dma interrupt once an async buffer has been transmitted */
+typedef void (*uart_tx_done_t)(uint8_t const *const buf);
+
 /**
  * @brief Initialise the uart hardware with the given baudrate
  *
@@ -32,6 +61,18 @@ typedef enum uart_id {
  */
 void uart_init(uart_id_t const uart_id, uint32_t const baud);
 
+/**
+ * @brief Receive into the uart's ring using circular dma instead of the RXNE interrupt
+ *
+ * The ring's head is updated on idle line detection and at the half/full transfer points, so
+ * the reader of uart_rx_get sees data arrive in chunks.
+ *
+ * @pre uart_init has been called, only UART1 and UART6 are supported
+ *
+ * @param uart_id[in] the id of the uart device
+ */
+void uart_rx_dma_enable(uart_id_t const uart_id);
+
 /**
  * @brief Check if there is data available to be read from the uart
  *
@@ -40,13 +81,66 @@ void uart_init(uart_id_t const uart_id, uint32_t const baud);
  */
 bool uart_read_ready(uart_id_t const uart_id);
 uint8_t uart_read_byte(uart_id_t const uart_id);
+
+/**
+ * @brief Queue a byte for transmission
+ *
+ * The byte is placed in the uart's transmit queue and sent from the TXE interrupt, so this
+ * returns without waiting for the byte to go out. If the queue is full, the caller busy-waits
+ * until there is room.
+ *
+ * @param uart_id[in] the id of the uart device
+ * @param byte[in] the byte to transmit
+ */
 void uart_write_byte(uart_id_t const uart_id, uint8_t const byte);
 void uart_write_hex_byte(uart_id_t const uart_id, uint8_t const byte);
 void uart_write_str(uart_id_t const uart_id, char const *const str);
 void uart_write_buf(uart_id_t const uart_id, uint32_t const size, uint8_t const buf[size]);
 void uart_write_hex_buf(uart_id_t const uart_id, uint32_t const size, uint8_t const buf[size]);
 
-/* Retrieve a pointer to the cbuf used to receive data in the isr */
-cbuf_t *uart_cbuf_get(uart_id_t const uart_id);
+/**
+ * @brief Queue a buffer to be transmitted by dma
+ *
+ * The whole buffer is sent with a single dma transfer, after any data queued before it.
+ * The buffer is not copied, so it must remain valid and unmodified until done is called.
+ *
+ * @pre size shall be in the range 1..65535
+ *
+ * @param uart_id[in] the id of the uart device
+ * @param size[in] the number of bytes to transmit
+ * @param buf[in] the data to transmit
+ * @param done[in] called from the dma interrupt once the buffer is sent (may be NULL)
+ * @return UART_STATUS_TX_QUEUE_FULL if UART_TX_DESC_COUNT buffers are already queued
+ */
+status_t uart_write_buf_async(
+    uart_id_t const uart_id,
+    uint32_t const size,
+    uint8_t const buf[size],
+    uart_tx_done_t const done);
+
+/* Number of async buffers queued or in flight */
+uint32_t uart_tx_pending(uart_id_t const uart_id);
+
+/* Received data lost because the reader fell behind: bytes dropped with the RXNE interrupt, or
+ * laps of the ring by the dma */
+uint32_t uart_rx_overruns(uart_id_t const uart_id);
+
+/**
+ * @brief Block until all queued data has been transmitted
+ *
+ * Drains the transmit queue by polling, so it is safe to call with interrupts masked (i.e.
+ * from fault handlers before a reset)
+ *
+ * @param uart_id[in] the id of the uart device
+ */
+void uart_flush(uart_id_t const uart_id);
+
+/* Submit work (rtos_work_submit) from the isr whenever data is received into the ring, NULL to
+ * disable */
+void uart_rx_notify(uart_id_t const uart_id, rtos_work_t *const work);
+
+/* Retrieve the ring the isr receives data into, it must only be read by one thread at a time
+ * (the isr is its only producer) */
+spsc_t *uart_rx_get(uart_id_t const uart_id);
 
 #endif /* UART_H_ */
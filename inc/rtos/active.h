@@ -0,0 +1,44 @@
+#ifndef RTOS_ACTIVE_H
+#define RTOS_ACTIVE_H
+
+#include "rtos/event.h"
+#include "rtos/hsm.h"
+#include "rtos/queue.h"
+#include "rtos/thread.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Active object, a state machine with its own thread and event queue. The thread blocks on the
+ * queue and dispatches one event at a time to the state machine, run to completion. Embed as the
+ * first member of the application's active object */
+typedef struct {
+    rtos_hsm_t hsm;
+    rtos_thread_t thread;
+    rtos_queue_t queue;
+    uint32_t queue_max; /* High-water mark of the event queue */
+} rtos_active_t;
+
+/* Construct an active object with the initial transition of its state machine */
+void rtos_active_ctor(rtos_active_t *const me, rtos_state_handler_t const initial);
+
+/* Start the active object's thread, which takes the initial transition and then handles events.
+ * queue_storage must hold queue_len event pointers, the stack must be defined with
+ * RTOS_THREAD_STACK */
+void rtos_active_start(
+    rtos_active_t *const me,
+    uint8_t const priority,
+    rtos_event_t const **const queue_storage,
+    uint32_t const queue_len,
+    void *const stack,
+    uint32_t const stack_size);
+
+/* Post an event to the back of an active object's queue, without blocking. Ownership of the
+ * event passes to the framework, if the queue is full it is garbage collected and false is
+ * returned. Can be called from isrs (outside the zero-latency band) */
+bool rtos_active_post(rtos_active_t *const me, rtos_event_t const *const e);
+
+/* Most events that have been waiting in an active object's queue */
+uint32_t rtos_active_queue_max(rtos_active_t const *const me);
+
+#endif /* RTOS_ACTIVE_H */
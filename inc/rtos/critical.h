@@ -0,0 +1,27 @@
+#ifndef RTOS_CRITICAL_H
+#define RTOS_CRITICAL_H
+
+#include <stdint.h>
+
+/* NVIC priority (0 is the most urgent) of the most urgent interrupt masked by rtos critical
+ * sections. Interrupts more urgent than this form the "zero-latency" band, which is never masked
+ * by the rtos, so their isrs must not call the rtos (except rtos_thread_signal) */
+#ifndef RTOS_KERNEL_IRQ_PRIORITY
+#define RTOS_KERNEL_IRQ_PRIORITY (4)
+#endif
+
+/* BASEPRI value masking the kernel aware interrupts, the priority is held in the top
+ * __NVIC_PRIO_BITS (4) bits. Written without suffixes as it's also used in inline assembly */
+#define RTOS_KERNEL_BASEPRI ((RTOS_KERNEL_IRQ_PRIORITY) << 4)
+
+/* Enter a critical section by masking interrupts at or below the kernel priority with BASEPRI,
+ * returning the previous mask so critical sections can be nested */
+uint32_t rtos_critical_enter(void);
+
+/* Exit a critical section, restoring the mask returned by rtos_critical_enter */
+void rtos_critical_exit(uint32_t const basepri);
+
+/* Longest time spent in an (outermost) critical section, in cpu cycles */
+uint32_t rtos_critical_max_cycles(void);
+
+#endif /* RTOS_CRITICAL_H */
@@ -0,0 +1,68 @@
+#ifndef RTOS_EVENT_H
+#define RTOS_EVENT_H
+
+#include "rtos/thread.h"
+#include "rtos/work.h"
+#include "utils/pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Signals reserved by the state machine dispatcher (see rtos/hsm.h), application signals start
+ * at RTOS_USER_SIG */
+enum {
+    RTOS_EMPTY_SIG = 0,
+    RTOS_ENTRY_SIG,
+    RTOS_EXIT_SIG,
+    RTOS_INIT_SIG,
+    RTOS_USER_SIG,
+};
+
+struct rtos_event_pool;
+
+/* Event header, embed as the first member of events carrying parameters. Events are immutable
+ * once posted, pooled events are returned to their pool once every receiver has handled them */
+typedef struct {
+    uint16_t sig;
+    uint8_t refs;                 /* Queues the event is posted to, or being handled from */
+    struct rtos_event_pool *pool; /* Pool the event was allocated from, NULL if static */
+} rtos_event_t;
+
+/* Fixed size event blocks, the semaphore counts the free blocks so allocations can block */
+typedef struct rtos_event_pool {
+    pool_t blocks;
+    rtos_sem_t free;
+    rtos_work_t *notify; /* Submitted whenever a block is freed, may be NULL */
+} rtos_event_pool_t;
+
+/* Initialise a pool of count events of block_size bytes from storage, declare the storage with
+ * POOL_STORAGE and pass POOL_BLOCK_SIZE of the event type */
+void rtos_event_pool_init(
+    rtos_event_pool_t *const self,
+    void *const storage,
+    size_t const block_size,
+    uint32_t const count);
+
+/* Submit work whenever an event is returned to the pool, NULL to disable. Lets work that can't
+ * block the work thread (see rtos/work.h) retry an allocation with a timeout of 0 */
+void rtos_event_pool_notify(rtos_event_pool_t *const self, rtos_work_t *const work);
+
+/* Fewest free blocks the pool has had */
+uint32_t rtos_event_pool_min_free(rtos_event_pool_t const *const self);
+
+/* Underlying block pool, for usage telemetry */
+pool_t const *rtos_event_pool_blocks(rtos_event_pool_t const *const self);
+
+/* Allocate an event from a pool, blocking for at most ticks while the pool is empty. Can be
+ * called from isrs with a timeout of 0. Returns NULL if the timeout expired */
+rtos_event_t *rtos_event_new(
+    rtos_event_pool_t *const pool,
+    uint16_t const sig,
+    uint32_t const ticks);
+
+/* Release a reference to an event, a pooled event is returned to its pool with the last one.
+ * Call on events that were allocated but never posted, posted events are released by the
+ * receiver. Can be called from isrs */
+void rtos_event_gc(rtos_event_t const *const event);
+
+#endif /* RTOS_EVENT_H */
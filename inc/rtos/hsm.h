@@ -0,0 +1,61 @@
+#ifndef RTOS_HSM_H
+#define RTOS_HSM_H
+
+#include "rtos/event.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Deepest nesting of states, counting from the top state */
+#define RTOS_HSM_MAX_DEPTH (6)
+
+/* Results of a state handler, returned through the macros below */
+typedef enum {
+    RTOS_RET_HANDLED = 0,
+    RTOS_RET_IGNORED,
+    RTOS_RET_TRAN,
+    RTOS_RET_SUPER,
+} rtos_state_t;
+
+struct rtos_hsm;
+
+/* A state is a handler function, returning the result of handling the event in that state. Every
+ * state but the top one must return RTOS_SUPER for the events it doesn't handle, including
+ * RTOS_EMPTY_SIG which is used to discover the hierarchy */
+typedef rtos_state_t (*rtos_state_handler_t)(
+    struct rtos_hsm *const me,
+    rtos_event_t const *const e);
+
+/* Hierarchical state machine, embed as the first member of the application's state machine so
+ * handlers can cast me to their own type */
+typedef struct rtos_hsm {
+    rtos_state_handler_t state; /* Current (leaf) state */
+    rtos_state_handler_t temp;  /* Target of a transition or superstate, set by the macros */
+} rtos_hsm_t;
+
+#define RTOS_HANDLED() (RTOS_RET_HANDLED)
+#define RTOS_IGNORED() (RTOS_RET_IGNORED)
+#define RTOS_TRAN(target)                                                                          \
+    (((rtos_hsm_t *)me)->temp = (rtos_state_handler_t)(target), RTOS_RET_TRAN)
+#define RTOS_SUPER(super)                                                                          \
+    (((rtos_hsm_t *)me)->temp = (rtos_state_handler_t)(super), RTOS_RET_SUPER)
+
+/* The top state, the superstate of every outermost state. Ignores every event */
+rtos_state_t rtos_hsm_top(rtos_hsm_t *const me, rtos_event_t const *const e);
+
+/* Construct a state machine, initial is the handler of the initial transition which must return
+ * RTOS_TRAN to the first state */
+void rtos_hsm_ctor(rtos_hsm_t *const me, rtos_state_handler_t const initial);
+
+/* Take the initial transition, entering the initial state (and nested initial transitions).
+ * The event is passed to the initial transition, and may be NULL */
+void rtos_hsm_init(rtos_hsm_t *const me, rtos_event_t const *const e);
+
+/* Dispatch an event to the current state and up through its superstates until it is handled,
+ * taking any transition with its exit, entry and initial actions (run to completion) */
+void rtos_hsm_dispatch(rtos_hsm_t *const me, rtos_event_t const *const e);
+
+/* Whether the state machine is in a state, directly or through one of its substates */
+bool rtos_hsm_is_in(rtos_hsm_t *const me, rtos_state_handler_t const state);
+
+#endif /* RTOS_HSM_H */
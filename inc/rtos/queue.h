@@ -0,0 +1,40 @@
+#ifndef RTOS_QUEUE_H
+#define RTOS_QUEUE_H
+
+#include "rtos/thread.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fixed size item queue. Items are copied in and out of caller provided storage, so for
+ * zero-copy handoff the items should be pointers to buffers owned by the sender until received */
+typedef struct {
+    uint8_t *storage;
+    size_t item_size;
+    uint32_t capacity;
+    uint32_t head; /* Index of the next item to receive */
+    uint32_t tail; /* Index of the next free slot */
+    rtos_sem_t items;
+    rtos_sem_t slots;
+} rtos_queue_t;
+
+/* Initialise an empty queue, storage must be at least (item_size * capacity) bytes */
+void rtos_queue_init(
+    rtos_queue_t *const self,
+    void *const storage,
+    size_t const item_size,
+    uint32_t const capacity);
+
+/* Copy an item to the back of the queue, blocking for at most ticks while the queue is full.
+ * Can be called from isrs with a timeout of 0. Returns false if the timeout expired */
+bool rtos_queue_send(rtos_queue_t *const self, void const *const item, uint32_t const ticks);
+
+/* Copy the item at the front of the queue out, blocking for at most ticks while the queue is
+ * empty. Can be called from isrs with a timeout of 0. Returns false if the timeout expired */
+bool rtos_queue_receive(rtos_queue_t *const self, void *const item, uint32_t const ticks);
+
+/* Number of items in the queue */
+uint32_t rtos_queue_count(rtos_queue_t const *const self);
+
+#endif /* RTOS_QUEUE_H */
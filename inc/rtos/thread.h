@@ -1,15 +1,109 @@
 #ifndef RTOS_THREAD_H
 #define RTOS_THREAD_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
-typedef struct {
+/* Timeout value to block without a timeout */
+#define RTOS_WAIT_FOREVER (0xFFFFFFFFU)
+
+/* Size in bytes of the MPU guard region, the bottom of each thread stack array. An overflow is
+ * only caught if it touches the guard before stepping over it, so the build limits every C stack
+ * frame to this size (-Werror=frame-larger-than in build.zig, keep the two in step) */
+#define RTOS_STACK_GUARD_SIZE (256U)
+
+/* Define a thread stack (of uint32_t words), aligned for its guard region and placed in the
+ * .thread_stacks section. Stacks aren't zero initialised, they're painted by rtos_thread_create */
+#define RTOS_THREAD_STACK(name, words)                                                             \
+    uint32_t name[(words)]                                                                         \
+        __attribute__((section(".thread_stacks"), aligned(RTOS_STACK_GUARD_SIZE)))
+
+/* CPU load is measured over windows of this many ticks */
+#define RTOS_LOAD_WINDOW_TICKS (1000U)
+
+/* Full scale of rtos_thread_load/rtos_cpu_load, loads are in hundredths of a percent */
+#define RTOS_LOAD_SCALE (10000U)
+
+/* Buckets of the response time histogram, each a quarter of the deadline wide. The first four
+ * count activations that met their deadline, the last also counts every later response */
+#define RTOS_RESPONSE_BUCKETS              (8U)
+#define RTOS_RESPONSE_BUCKETS_PER_DEADLINE (4U)
+
+/* Number of priority levels, including the idle thread's priority 0. Any number of threads can
+ * share a level */
+#ifndef RTOS_PRIORITY_COUNT
+#define RTOS_PRIORITY_COUNT (64U)
+#endif
+
+/* Default time slice in ticks of a thread sharing its priority level with other ready threads,
+ * 0 disables time slicing (threads run until they block) */
+#ifndef RTOS_TIME_SLICE_TICKS
+#define RTOS_TIME_SLICE_TICKS (10U)
+#endif
+
+struct rtos_mutex;
+
+typedef struct rtos_thread {
     void *sp; /* Stack Pointer */
-    uint32_t timeout;
-    uint8_t priority;
+    uint32_t timeout;               /* Ticks after the previous delayed thread wakes */
+    struct rtos_thread *delay_next; /* Delay list, sorted by wake-up time */
+    struct rtos_thread *delay_prev;
+    struct rtos_thread *ready_next; /* Ready list of the thread's priority, NULL if not ready */
+    struct rtos_thread *ready_prev;
+    struct rtos_thread *list_next;  /* All threads, in the order they were created */
+    uint8_t priority;               /* Current priority, differs from base when inherited */
+    uint8_t base_priority;          /* Priority the thread was created with */
+    uint8_t id;                     /* Index of the thread in creation order (idle is 0) */
+    volatile bool signalled;        /* Set by rtos_thread_signal, cleared by rtos_thread_wait */
+    volatile bool signal_deferred;  /* Signalled from a zero-latency isr, delivered by PendSV */
+    bool waiting_signal;            /* Blocked in rtos_thread_wait */
+    bool activation_started;        /* Between rtos_thread_activation_start and _end */
+    bool activation_woken;          /* Made ready since its last activation ended */
+    struct rtos_thread **wait_list; /* Waiting list of the object the thread is blocked on */
+    struct rtos_thread *wait_next;  /* Waiting list, sorted by priority */
+    struct rtos_mutex *held;        /* Mutexes owned by this thread */
+    struct rtos_mutex *blocked_on;  /* Mutex the thread is waiting for, NULL if none */
+    uint32_t cycles;                /* Cycles run in the current load window */
+    uint32_t load_cycles;           /* Cycles run in the last complete load window */
+    uint32_t *stack_limit;          /* Lowest word of the (painted) stack, above the guard */
+    uint32_t *stack_top;            /* End of the stack */
+    uint32_t stack_used;            /* Stack high-water mark in bytes, updated by the idle thread */
+    uint32_t release_cycles;        /* CYCCNT when last woken by the tick */
+    uint32_t latency_min;           /* Release to run latency in rtos_delay_until, in cycles */
+    uint32_t latency_max;
+    uint32_t overruns;              /* Periods missed by rtos_delay_until */
+    uint32_t time_slice;            /* Ticks run before yielding to a thread of equal priority */
+    uint32_t slice_remaining;       /* Ticks left of the current slice */
+    uint32_t deadline;              /* Relative deadline of each activation in cycles, 0 if off */
+    uint32_t activation_cycles;     /* CYCCNT the current activation was released at */
+    uint32_t response_min;          /* Activation response times, in cycles */
+    uint32_t response_max;
+    uint32_t deadline_misses;       /* Activations that finished after their deadline */
+    uint32_t response_histogram[RTOS_RESPONSE_BUCKETS];
     /* ... */
 } rtos_thread_t;
 
+/* Counting semaphore. Blocked threads are parked in a list sorted by priority (first come first
+ * served within a priority) so the highest priority waiter is woken first */
+typedef struct {
+    uint32_t count;
+    rtos_thread_t *waiting;
+} rtos_sem_t;
+
+/* Mutex with priority inheritance. While a higher priority thread is waiting, the owner runs
+ * at the waiter's priority, and drops back when the mutex is unlocked. If the owner is itself
+ * blocked on another mutex the boost is passed along the chain of owners, up to
+ * RTOS_MUTEX_INHERIT_DEPTH mutexes. Mutexes can be locked recursively by their owner, and must
+ * only be used from threads */
+#define RTOS_MUTEX_INHERIT_DEPTH (4U)
+
+typedef struct rtos_mutex {
+    rtos_thread_t *owner;
+    uint32_t nest;
+    rtos_thread_t *waiting;
+    struct rtos_mutex *next_held; /* Next mutex owned by the same thread */
+} rtos_mutex_t;
+
 typedef void (*rtos_thread_handler_t)(void);
 
 /* idle thread callback (define in application) */
@@ -21,19 +115,131 @@ void rtos_on_startup(void);
 /* Initialise the rtos and idle thread */
 void rtos_init(void *const idle_thread_stack, uint32_t const idle_thread_stack_size);
 
-/* This function requires interrupts be disabled */
+/* This function requires a critical section (rtos_critical_enter) */
 void rtos_schedule(void);
 
 /* Run the rtos */
 void rtos_run(void);
 
-/* Process thread timeouts */
+/* Process thread timeouts, only the threads expiring on this tick are visited */
 void rtos_tick(void);
 
+/* Process several ticks at once, e.g. after sleeping through them in tickless idle */
+void rtos_tick_advance(uint32_t ticks);
+
+/* Ticks until the next delayed thread wakes up, 0 if a thread is ready to run or
+ * RTOS_WAIT_FOREVER if no thread is delayed. This function requires a critical section */
+uint32_t rtos_idle_ticks(void);
+
 /* Blocking delay */
 void rtos_delay(uint32_t ticks);
 
-/* Register a thread with the rtos */
+/* Fixed rate delay for periodic threads, blocks until last_wake + period and advances last_wake
+ * to it. Initialise last_wake with rtos_tick_count(). If the release time has already passed
+ * (the thread overran its period) it returns immediately and counts an overrun */
+void rtos_delay_until(uint32_t *const last_wake, uint32_t const period);
+
+/* Ticks since the rtos started */
+uint32_t rtos_tick_count(void);
+
+/* Cpu cycles since the start of a tick that has already been reached, ticks before the last one
+ * are counted at the measured tick period */
+uint32_t rtos_tick_lateness(uint32_t const tick);
+
+/* Wake a thread blocked in rtos_thread_wait (or make its next wait return immediately).
+ * Can be called from isrs, including those in the zero-latency band (see rtos/critical.h) */
+void rtos_thread_signal(rtos_thread_t *const thread);
+
+/* Block until the thread is signalled or the timeout (in ticks) expires. A timeout of 0 only
+ * checks for a pending signal, RTOS_WAIT_FOREVER waits without a timeout. Returns true if
+ * signalled */
+bool rtos_thread_wait(uint32_t const ticks);
+
+/* Initialise a semaphore with an initial count */
+void rtos_sem_init(rtos_sem_t *const self, uint32_t const count);
+
+/* Decrement the semaphore, blocking until the count is non-zero */
+void rtos_sem_take(rtos_sem_t *const self);
+
+/* Decrement the semaphore, blocking for at most ticks until the count is non-zero. A timeout of
+ * 0 doesn't block. Returns false if the timeout expired */
+bool rtos_sem_take_timeout(rtos_sem_t *const self, uint32_t const ticks);
+
+/* Increment the semaphore, or wake the highest priority waiting thread. Can be called from
+ * isrs */
+void rtos_sem_give(rtos_sem_t *const self);
+
+/* Initialise an unlocked mutex */
+void rtos_mutex_init(rtos_mutex_t *const self);
+
+/* Lock the mutex, blocking until it is released by its owner. The owner inherits the priority of
+ * the thread if it is higher */
+void rtos_mutex_lock(rtos_mutex_t *const self);
+
+/* Unlock the mutex, handing it over to the highest priority waiting thread */
+void rtos_mutex_unlock(rtos_mutex_t *const self);
+
+/* Get the running thread, NULL before rtos_run */
+rtos_thread_t *rtos_thread_self(void);
+
+/* Share of the last load window a thread ran for, out of RTOS_LOAD_SCALE */
+uint32_t rtos_thread_load(rtos_thread_t const *const thread);
+
+/* Jitter of a periodic thread's release to run latency in rtos_delay_until (max - min), in cpu
+ * cycles */
+uint32_t rtos_thread_jitter(rtos_thread_t const *const thread);
+
+/* Number of periods a thread overran in rtos_delay_until */
+uint32_t rtos_thread_overruns(rtos_thread_t const *const thread);
+
+/* Monitor the response time of each activation of a thread against a relative deadline in cpu
+ * cycles (0 stops monitoring), clearing its response statistics. An activation is bracketed by
+ * rtos_thread_activation_start and rtos_thread_activation_end (rtos_delay_until does both for a
+ * periodic thread), its response time is measured from its release: when the thread was woken to
+ * receive the event that started it, or the end of the previous activation if the event was
+ * already waiting */
+void rtos_thread_set_deadline(rtos_thread_t *const thread, uint32_t const cycles);
+
+/* Start an activation of the running thread, call once the event it handles has been received.
+ * Blocking within the activation (e.g. on a mutex) doesn't move its release */
+void rtos_thread_activation_start(void);
+
+/* End the running thread's activation, e.g. once it has finished handling an event and is about
+ * to wait for the next one. Ignored outside an activation */
+void rtos_thread_activation_end(void);
+
+/* Shortest and longest activation response times of a thread, in cpu cycles */
+uint32_t rtos_thread_response_min(rtos_thread_t const *const thread);
+uint32_t rtos_thread_response_max(rtos_thread_t const *const thread);
+
+/* Number of activations of a thread that missed their deadline */
+uint32_t rtos_thread_deadline_misses(rtos_thread_t const *const thread);
+
+/* Copy out a thread's response time histogram, see RTOS_RESPONSE_BUCKETS */
+void rtos_thread_response_histogram(
+    rtos_thread_t const *const thread,
+    uint32_t histogram[RTOS_RESPONSE_BUCKETS]);
+
+/* Deepest stack usage in bytes seen so far by the stack scanner, which checks the stack paint
+ * from the idle thread */
+uint32_t rtos_thread_stack_used(rtos_thread_t const *const thread);
+
+/* Get the idle thread */
+rtos_thread_t *rtos_thread_idle(void);
+
+/* Share of the last load window spent outside the idle thread, out of RTOS_LOAD_SCALE */
+uint32_t rtos_cpu_load(void);
+
+/* Set the time slice of a thread in ticks, 0 lets it run until it blocks even when other
+ * threads of its priority are ready */
+void rtos_thread_set_time_slice(rtos_thread_t *const thread, uint32_t const ticks);
+
+/* Context switch accounting and stack guard setup for rtos_next, called from PendSV */
+void rtos_thread_switch_hook(void);
+
+/* Register a thread with the rtos at a priority below RTOS_PRIORITY_COUNT, threads of equal
+ * priority take turns in time slices of RTOS_TIME_SLICE_TICKS. The stack must be defined with
+ * RTOS_THREAD_STACK, its first RTOS_STACK_GUARD_SIZE bytes are reserved as the MPU guard region */
 void rtos_thread_create(
     rtos_thread_t *const self,
     rtos_thread_handler_t const handler,
@@ -0,0 +1,55 @@
+#ifndef RTOS_TIMER_H
+#define RTOS_TIMER_H
+
+#include "rtos/thread.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Stack size (in words) of the timer thread, callbacks run on it */
+#define RTOS_TIMER_STACK_SIZE (512)
+
+typedef void (*rtos_timer_callback_t)(void *const arg);
+
+/* Software timer. Callbacks run in the timer thread, so must not block for long as they delay
+ * the other timers */
+typedef struct rtos_timer {
+    rtos_timer_callback_t callback;
+    void *arg;
+    uint32_t expiry;         /* Tick count the timer expires at */
+    uint32_t period;         /* Ticks between expiries, 0 for a one-shot timer */
+    bool active;
+    struct rtos_timer *next; /* Active timers, sorted by expiry */
+    uint32_t latency_min;    /* Expiry to callback latency, in cycles */
+    uint32_t latency_max;
+    uint32_t overruns;       /* Periods missed as the callback ran too late */
+} rtos_timer_t;
+
+/* Create the timer thread, call before rtos_run */
+void rtos_timer_service_init(uint8_t const priority);
+
+/* Get the timer thread */
+rtos_thread_t *rtos_timer_service_thread(void);
+
+/* Initialise a stopped timer calling callback(arg) on expiry */
+void rtos_timer_init(rtos_timer_t *const self, rtos_timer_callback_t const callback, void *arg);
+
+/* Start (or restart) a timer to expire in delay ticks, then every period ticks if period is not
+ * 0. Periodic expiries are relative to the previous expiry so they don't drift. Can be called
+ * from isrs (outside the zero-latency band) */
+void rtos_timer_start(rtos_timer_t *const self, uint32_t const delay, uint32_t const period);
+
+/* Stop a timer, a callback already being run by the timer thread isn't cancelled */
+void rtos_timer_stop(rtos_timer_t *const self);
+
+/* Whether the timer is waiting to expire */
+bool rtos_timer_active(rtos_timer_t const *const self);
+
+/* Jitter of a timer's callback latency from the tick it expired on (max - min), in cpu cycles */
+uint32_t rtos_timer_jitter(rtos_timer_t const *const self);
+
+/* Number of periods a periodic timer's callback ran too late for, it is run again straight away
+ * for each */
+uint32_t rtos_timer_overruns(rtos_timer_t const *const self);
+
+#endif /* RTOS_TIMER_H */
@@ -0,0 +1,78 @@
+#ifndef RTOS_TRACE_H
+#define RTOS_TRACE_H
+
+#include "rtos/thread.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Record scheduler events into the trace buffer, set to 0 to compile the recorder out */
+#ifndef RTOS_TRACE_ENABLE
+#define RTOS_TRACE_ENABLE (1)
+#endif
+
+/* Records held in the trace buffer (a power of two), the oldest are overwritten when it is full */
+#ifndef RTOS_TRACE_SIZE
+#define RTOS_TRACE_SIZE (512U)
+#endif
+
+/* Thread id recorded for events outside of any thread (before rtos_run) */
+#define RTOS_TRACE_NO_THREAD (0xFFU)
+
+/* Trace events, the meaning of the record's thread and arg depends on the event */
+typedef enum {
+    RTOS_TRACE_SWITCH = 0,    /* thread: switched out, arg: id of the thread switched in */
+    RTOS_TRACE_READY,         /* thread: made ready to run, arg: its priority */
+    RTOS_TRACE_ISR_ENTER,     /* thread: interrupted, arg: exception number */
+    RTOS_TRACE_ISR_EXIT,      /* thread: interrupted, arg: exception number */
+    RTOS_TRACE_DELAY,         /* thread: delayed, arg: ticks (saturated to 0xFFFF) */
+    RTOS_TRACE_SEM_TAKE,      /* thread: taking, arg: low half of the semaphore's address */
+    RTOS_TRACE_SEM_BLOCK,     /* thread: blocked, arg: low half of the semaphore's address */
+    RTOS_TRACE_SEM_TIMEOUT,   /* thread: timed out, arg: low half of the semaphore's address */
+    RTOS_TRACE_SEM_GIVE,      /* thread: giving, arg: low half of the semaphore's address */
+    RTOS_TRACE_DEADLINE_MISS, /* thread: missed, arg: response time as a % of the deadline */
+} rtos_trace_event_t;
+
+/* A trace record, cycles is the DWT cycle counter when the event was recorded */
+typedef struct {
+    uint32_t cycles;
+    uint8_t event;
+    uint8_t thread; /* Thread id, see rtos_thread_t */
+    uint16_t arg;
+} rtos_trace_record_t;
+
+#if RTOS_TRACE_ENABLE
+#define RTOS_TRACE(event, thread, arg) rtos_trace_record((event), (thread), (uint32_t)(arg))
+#define RTOS_TRACE_ISR_ENTER()         rtos_trace_isr(RTOS_TRACE_ISR_ENTER)
+#define RTOS_TRACE_ISR_EXIT()          rtos_trace_isr(RTOS_TRACE_ISR_EXIT)
+#else
+#define RTOS_TRACE(event, thread, arg) ((void)0)
+#define RTOS_TRACE_ISR_ENTER()         ((void)0)
+#define RTOS_TRACE_ISR_EXIT()          ((void)0)
+#endif
+
+/* Record an event, use the RTOS_TRACE macros so the calls compile out with the recorder. Only
+ * masks interrupts for the few cycles it takes to claim a record, so can be called from any isr,
+ * including those in the zero-latency band */
+void rtos_trace_record(
+    rtos_trace_event_t const event,
+    rtos_thread_t const *const thread,
+    uint32_t const arg);
+
+/* Record entry to or exit from the running isr */
+void rtos_trace_isr(rtos_trace_event_t const event);
+
+/* Stop recording, e.g. to download the buffer or to keep the events leading up to a fault */
+void rtos_trace_stop(void);
+
+/* Resume recording */
+void rtos_trace_start(void);
+
+/* Number of events recorded since startup, the last RTOS_TRACE_SIZE are kept in the buffer */
+uint32_t rtos_trace_count(void);
+
+/* Copy out the index'th event recorded since startup, returns false if it hasn't been recorded
+ * yet or has already been overwritten */
+bool rtos_trace_read(uint32_t const index, rtos_trace_record_t *const record);
+
+#endif /* RTOS_TRACE_H */
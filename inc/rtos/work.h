@@ -0,0 +1,37 @@
+#ifndef RTOS_WORK_H
+#define RTOS_WORK_H
+
+#include "rtos/thread.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Stack size (in words) of the work thread, work handlers run on it */
+#define RTOS_WORK_STACK_SIZE (256)
+
+typedef void (*rtos_work_handler_t)(void *const arg);
+
+/* Deferred work, submitted by isrs (or threads) to be run by the work thread. Handlers run one
+ * after another, so must not block for long as they delay the rest of the queue */
+typedef struct rtos_work {
+    rtos_work_handler_t handler;
+    void *arg;
+    volatile uint32_t pending;    /* Set from submission until the handler is started */
+    struct rtos_work *volatile next;
+} rtos_work_t;
+
+/* Create the work thread, call before rtos_run */
+void rtos_work_service_init(uint8_t const priority);
+
+/* Get the work thread */
+rtos_thread_t *rtos_work_service_thread(void);
+
+/* Initialise work calling handler(arg) when run */
+void rtos_work_init(rtos_work_t *const self, rtos_work_handler_t const handler, void *arg);
+
+/* Queue work to be run by the work thread, in the order submitted. Returns false if it is
+ * already queued (it is only run once). Lock-free, so can be called from any isr including those
+ * in the zero-latency band. Work can be resubmitted from its own handler */
+bool rtos_work_submit(rtos_work_t *const self);
+
+#endif /* RTOS_WORK_H */
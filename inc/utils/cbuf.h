@@ -6,15 +6,19 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define CBUF_SIZE (1024)
-
+/* Ring buffer over caller provided storage, so each instance is sized for its use. The storage
+ * must be a power of two bytes, one is kept free to tell a full buffer from an empty one */
 typedef struct cbuf {
     size_t write;
     size_t read;
-    uint8_t buf[CBUF_SIZE];
+    uint8_t *buf;
+    size_t mask;
 } cbuf_t;
 
-void cbuf_init(cbuf_t *const self);
+void cbuf_init(cbuf_t *const self, uint8_t *const storage, size_t const capacity);
+
+/* Most bytes the buffer can hold */
+size_t cbuf_capacity(cbuf_t const *const self);
 
 size_t cbuf_size(cbuf_t const *const self);
 
@@ -26,4 +30,20 @@ status_t cbuf_read(cbuf_t *const self, size_t const size, uint8_t dest[size]);
 
 status_t cbuf_write(cbuf_t *const self, size_t const size, uint8_t const src[size]);
 
+/* Zero-copy access. The data (or free space) may wrap around the end of the storage, so each call
+ * returns the contiguous span up to the wrap, call again after consuming (or committing) it for
+ * the rest. A size of 0 means there is nothing to read (or no room) */
+
+/* Oldest unread bytes, left in the buffer until consumed */
+void cbuf_peek_contiguous(cbuf_t const *const self, uint8_t const **const span, size_t *const size);
+
+/* Discard size bytes from the start of the peeked data */
+void cbuf_consume(cbuf_t *const self, size_t const size);
+
+/* Free space to write into directly, the bytes are not readable until committed */
+void cbuf_reserve(cbuf_t *const self, uint8_t **const span, size_t *const size);
+
+/* Make size bytes written into the reserved span readable */
+void cbuf_commit(cbuf_t *const self, size_t const size);
+
 #endif /* CBUF_H_ */
@@ -8,12 +8,13 @@
 #define STRINGIZE_DETAIL(x) #x
 #define STRINGIZE(x)        STRINGIZE_DETAIL(x)
 
-/* Debug Macros for printing file and line */
-#define DEBUG(msg, status)    debug_status(__FILE__ ":" STRINGIZE(__LINE__) ": " msg, (status))
-#define DEBUG_INT(msg, value) debug_int(__FILE__ ":" STRINGIZE(__LINE__) ": " msg, (value))
-#define DEBUG_HEX(msg, size, buf)                                                                  \
-    debug_hex(__FILE__ ":" STRINGIZE(__LINE__) ": " msg, (size), (buf))
-#define DEBUG_STR(msg) debug_str(__FILE__ ":" STRINGIZE(__LINE__) ": " msg)
+/* Debug Macros for printing file and line. msg is pasted onto the location, so it can only be a
+ * string literal and is sent by dma without being copied */
+#define DEBUG_LOCATION(msg) __FILE__ ":" STRINGIZE(__LINE__) ": " msg
+#define DEBUG(msg, status)    debug_status_literal(DEBUG_LOCATION(msg), (status))
+#define DEBUG_INT(msg, value) debug_int_literal(DEBUG_LOCATION(msg), (value))
+#define DEBUG_HEX(msg, size, buf) debug_hex_literal(DEBUG_LOCATION(msg), (size), (buf))
+#define DEBUG_STR(msg)        debug_str_literal(DEBUG_LOCATION(msg))
 
 /* Setup the debug log with a uart peripheral and baud rate */
 void debug_init(uart_id_t const uart_id, uint32_t const baud);
@@ -31,4 +32,11 @@ void debug_hex(char const *const msg, uint32_t const size, uint8_t const buf[siz
 /* Print an integer value (32-bit) */
 void debug_int(char const *const msg, uint32_t value);
 
+/* As above, but msg is sent by dma without being copied so must stay valid until it is sent.
+ * Only for the DEBUG macros, which can only pass string literals */
+void debug_status_literal(char const *const msg, status_t status);
+void debug_str_literal(char const *const msg);
+void debug_hex_literal(char const *const msg, uint32_t const size, uint8_t const buf[size]);
+void debug_int_literal(char const *const msg, uint32_t value);
+
 #endif /* DEBUG_H_ */
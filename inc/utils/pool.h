@@ -0,0 +1,60 @@
+#ifndef UTILS_POOL_H_
+#define UTILS_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Size classes that can be registered with pool_register */
+#define POOL_CLASS_MAX (4)
+
+/* Declare storage for count blocks of block_size bytes, block_size is rounded up to keep every
+ * block word aligned */
+#define POOL_STORAGE(name, block_size, count)                                                      \
+    uint32_t name[(((block_size) + sizeof(uint32_t) - 1U) / sizeof(uint32_t)) * (count)]
+
+/* Block size used for storage declared with POOL_STORAGE */
+#define POOL_BLOCK_SIZE(block_size)                                                                \
+    ((((block_size) + sizeof(uint32_t) - 1U) / sizeof(uint32_t)) * sizeof(uint32_t))
+
+/* Link overlaid on the start of a free block */
+typedef struct pool_block {
+    struct pool_block *next;
+} pool_block_t;
+
+/* Fixed size blocks, the free blocks are a stack pushed and popped with LDREX/STREX so blocks can
+ * be allocated and freed from threads and isrs of any priority without a critical section */
+typedef struct {
+    pool_block_t *volatile free;
+    uint8_t *start; /* Storage, to find the pool a block belongs to */
+    uint8_t *end;
+    size_t block_size;
+    uint32_t count;
+    volatile uint32_t used;
+    volatile uint32_t used_max;   /* High-water mark of the allocated blocks */
+    volatile uint32_t fail_count; /* Allocations made while the pool was empty */
+} pool_t;
+
+/* Initialise a pool of count blocks of block_size bytes (a multiple of 4) from storage */
+void pool_init(
+    pool_t *const self,
+    void *const storage,
+    size_t const block_size,
+    uint32_t const count);
+
+/* Allocate a block from a pool, returns NULL if the pool is empty. O(1), can be called from isrs */
+void *pool_block_alloc(pool_t *const self);
+
+/* Return a block to the pool it was allocated from. O(1), can be called from isrs */
+void pool_block_free(pool_t *const self, void *const block);
+
+/* Add a pool as a size class for pool_alloc, pools must be registered in increasing block size */
+void pool_register(pool_t *const pool);
+
+/* Allocate a block of at least size bytes from the smallest registered size class with a free
+ * block, returns NULL if none has. Can be called from isrs */
+void *pool_alloc(size_t const size);
+
+/* Return a block allocated by pool_alloc to its size class. Can be called from isrs */
+void pool_free(void *const block);
+
+#endif /* UTILS_POOL_H_ */
@@ -0,0 +1,60 @@
+#ifndef SPSC_H_
+#define SPSC_H_
+
+#include "utils/status.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Byte ring with a single producer and a single consumer, e.g. an isr and a thread. Each index is
+ * only written by one side and published after the data it covers, so neither side needs a
+ * critical section. The indices run freely and are masked into the storage, so every byte of the
+ * storage is usable and count is just head - tail.
+ *
+ * A producer that writes regardless of the tail (circular dma) can lap the consumer. It may also
+ * have written up to lag bytes past the published head, so the consumer treats a backlog within
+ * lag of the capacity as overrun too. It then drops the data and resyncs to the head */
+typedef struct {
+    volatile uint32_t head;    /* Written by the producer only */
+    volatile uint32_t tail;    /* Written by the consumer only */
+    volatile uint32_t dropped; /* Bytes spsc_put dropped as the ring was full, producer only */
+    uint32_t overruns;         /* Times the producer lapped the consumer, consumer only */
+    uint32_t lag;              /* Bytes the producer may write before publishing them */
+    uint8_t *buf;
+    uint32_t mask;
+} spsc_t;
+
+/* Initialise a ring over storage of capacity bytes, capacity must be a power of two */
+void spsc_init(spsc_t *const self, uint8_t *const storage, uint32_t const capacity);
+
+/* Set how far (in bytes) a producer that doesn't wait for the tail can write past the published
+ * head, i.e. half the storage for circular dma published on its half/full transfer interrupts */
+void spsc_set_lag(spsc_t *const self, uint32_t const lag);
+
+/* Bytes available to the consumer, more than the capacity if the producer has lapped it */
+uint32_t spsc_count(spsc_t const *const self);
+
+/* Bytes of room available to the producer */
+uint32_t spsc_space(spsc_t const *const self);
+
+/* Producer: append a byte, returns false (dropping the byte) if the ring is full */
+bool spsc_put(spsc_t *const self, uint8_t const value);
+
+/* Producer: publish bytes written into the storage by other means (i.e. circular dma), up to
+ * offset into the storage. Must be called at least every half lap of the storage (e.g. on the
+ * dma's half and full transfer interrupts) so the head counts every lap */
+void spsc_produce_to(spsc_t *const self, uint32_t const offset);
+
+/* Consumer: take a byte, returns false if the ring is empty */
+bool spsc_get(spsc_t *const self, uint8_t *const value);
+
+/* Consumer: take size bytes, all or nothing. Returns CBUF_STATUS_OVERRUN, having dropped
+ * everything received so far, if the producer (counting its lag) may have lapped the consumer
+ * before or while copying */
+status_t spsc_read(spsc_t *const self, size_t const size, uint8_t dest[size]);
+
+/* Bytes dropped by spsc_put plus laps detected by the consumer */
+uint32_t spsc_overruns(spsc_t const *const self);
+
+#endif /* SPSC_H_ */
@@ -12,6 +12,7 @@ typedef enum status {
     CBUF_STATUS_BUFFER_OVERFLOW = 0x10,
     CBUF_STATUS_CBUF_FULL,
     CBUF_STATUS_CBUF_EMPTY,
+    CBUF_STATUS_OVERRUN,
 
     SPACEPACKET_STATUS_INVALID_VERSION = 0x20,
     SPACEPACKET_STATUS_INVALID_TYPE,
@@ -33,6 +34,19 @@ typedef enum status {
     TELEMETRY_STATUS_INVALID_HANDLER_REGISTRATION = 0x50,
     TELEMETRY_STATUS_INVALID_PAYLOAD_SIZE,
     TELEMETRY_STATUS_INVALID_TELEMETRY_ID,
+    TELEMETRY_STATUS_RETIRED_TELEMETRY_ID,
+
+    UART_STATUS_TX_QUEUE_FULL = 0x60,
+
+    FRAME_BUFFER_STATUS_NO_FREE_FRAME = 0x70,
+    FRAME_BUFFER_STATUS_EMPTY,
+    FRAME_BUFFER_STATUS_FULL,
+
+    TRACE_STATUS_INVALID_PAYLOAD_SIZE = 0x80,
+    TRACE_STATUS_INVALID_COMMAND,
+    TRACE_STATUS_RECORD_UNAVAILABLE,
+
+    POOL_STATUS_EMPTY = 0x90,
 
     /* Used to identify the size of the status enum */
     STATUS_MAX,
@@ -4,10 +4,12 @@
 #include "app/parameter.h"
 #include "app/spacepacket.h"
 #include "app/telemetry.h"
+#include "app/trace.h"
 
 apid_handler_t apid_handler_map[APID_HANDLER_MAP_SIZE] = {
     [0] = action_handler,
     [1] = get_parameter_handler,
     [2] = set_parameter_handler,
     [3] = telemetry_handler,
+    [4] = trace_handler,
 };
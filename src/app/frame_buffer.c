@@ -1,10 +1,10 @@
 #include "app/frame_buffer.h"
 
-#include "rtos/thread.h"
-#include "utils/cbuf.h"
+#include "rtos/active.h"
+#include "rtos/event.h"
 #include "utils/dbc_assert.h"
-#include "utils/debug.h"
 #include "utils/endian.h"
+#include "utils/pool.h"
 #include "utils/status.h"
 
 #include <stdbool.h>
@@ -13,139 +13,105 @@
 #include <string.h>
 
 static struct {
-    cbuf_t cbuf;
-    bool ready;
-    bool lock;
-    status_t read_last_status;
+    POOL_STORAGE(frames, sizeof(frame_t), FRAME_BUFFER_COUNT);
+    rtos_event_pool_t pool; /* Empty frames */
+    rtos_active_t *reader;
+    uint16_t sig;
     status_t write_last_status;
-    uint32_t read_error_count;
     uint32_t write_error_count;
+    uint32_t alloc_fail_count; /* Allocations that found no free frame */
 } self = {0};
 
-static status_t frame_buffer_read_inner(cbuf_t *const cbuf)
+void frame_buffer_init(rtos_active_t *const reader, uint16_t const sig)
 {
-    if (!self.ready) {
-        return STATUS_OK;
-    }
-
-    /* Mutex, if packet buffer is locked, delay and retry */
-    while (self.lock) {
-        rtos_delay(2);
-    }
-    self.lock = true;
-
-    size_t size = cbuf_size(&self.cbuf);
-    uint8_t tmp_buf[CBUF_SIZE] = {0};
-    status_t status = cbuf_read(&self.cbuf, size, tmp_buf);
-
-    if (status != STATUS_OK) {
-        self.ready = false;
-        cbuf_init(&self.cbuf);
-        /* Release mutex lock */
-        self.lock = false;
-        return status;
-    }
-    /* Release mutex lock */
-    self.lock = false;
-    self.ready = false;
-
-    /* Place contents of buffer into cbuf */
-    status = cbuf_write(cbuf, size, tmp_buf);
-    if (status != STATUS_OK) {
-        DEBUG("Failed to write tmp buf to spacepacket cbuf", status);
-        cbuf_init(cbuf);
-    }
+    DBC_REQUIRE(reader != NULL);
 
-    return status;
+    memset(&self, 0, sizeof(self));
+    rtos_event_pool_init(
+        &self.pool,
+        self.frames,
+        POOL_BLOCK_SIZE(sizeof(frame_t)),
+        FRAME_BUFFER_COUNT);
+    self.reader = reader;
+    self.sig = sig;
 }
 
-static status_t frame_buffer_write_inner(size_t const size, uint8_t const buf[size])
+status_t frame_buffer_alloc(frame_t **const frame, uint32_t const ticks)
 {
-    status_t status = STATUS_OK;
+    DBC_REQUIRE(frame != NULL);
 
-    /* Mutex, if frame buffer is locked, delay and retry */
-    while (self.lock) {
-        rtos_delay(2);
+    *frame = (frame_t *)rtos_event_new(&self.pool, self.sig, ticks);
+    if (*frame == NULL) {
+        self.alloc_fail_count++;
+        return FRAME_BUFFER_STATUS_NO_FREE_FRAME;
     }
-    self.lock = true;
-    status = cbuf_write(&self.cbuf, size, buf);
-    if (status != STATUS_OK) {
-        self.ready = false;
-        /* Release frame buffer mutex */
-        self.lock = false;
-        return status;
-    }
-    /* Mark frame buffer as ready */
-    self.ready = true;
-    /* Release frame buffer mutex */
-    self.lock = false;
-    return status;
+    (*frame)->size = 0;
+    return STATUS_OK;
 }
 
-void frame_buffer_init(void)
-{
-    memset(&self, 0, sizeof(self));
-    cbuf_init(&self.cbuf);
-}
+void frame_buffer_notify(rtos_work_t *const work) { rtos_event_pool_notify(&self.pool, work); }
 
-status_t frame_buffer_read(cbuf_t *const cbuf)
+void frame_buffer_free(frame_t *const frame)
 {
-    status_t status = frame_buffer_read_inner(cbuf);
-    if (status != STATUS_OK) {
-        self.read_error_count++;
-    }
-    self.read_last_status = status;
-    return status;
+    DBC_REQUIRE(frame != NULL);
+
+    rtos_event_gc(&frame->super);
 }
 
-status_t frame_buffer_write(size_t const size, uint8_t const buf[size])
+status_t frame_buffer_write(frame_t *const frame)
 {
-    status_t status = frame_buffer_write_inner(size, buf);
-    if (status != STATUS_OK) {
+    DBC_REQUIRE(frame != NULL);
+    DBC_REQUIRE(frame->size <= FRAME_BUFFER_SIZE);
+
+    status_t status = STATUS_OK;
+    if (!rtos_active_post(self.reader, &frame->super)) {
+        status = FRAME_BUFFER_STATUS_FULL;
         self.write_error_count++;
     }
     self.write_last_status = status;
     return status;
 }
 
+pool_t const *frame_buffer_pool(void) { return rtos_event_pool_blocks(&self.pool); }
+
 /* Telemetry Handlers */
 
-status_t frame_buffer_read_error_count(size_t *const size, uint8_t *const output)
+status_t frame_buffer_free_min(size_t *const size, uint8_t *const output)
 {
     DBC_REQUIRE(size != NULL);
     DBC_REQUIRE(output != NULL);
 
     *size = 4;
-    endian_u32_to_network(self.read_error_count, output);
+    endian_u32_to_network(rtos_event_pool_min_free(&self.pool), output);
     return STATUS_OK;
 }
 
-status_t frame_buffer_read_last_status(size_t *const size, uint8_t *const output)
+status_t frame_buffer_write_error_count(size_t *const size, uint8_t *const output)
 {
     DBC_REQUIRE(size != NULL);
     DBC_REQUIRE(output != NULL);
 
-    *size = 1;
-    output[0] = (uint8_t)self.read_last_status;
+    *size = 4;
+    endian_u32_to_network(self.write_error_count, output);
     return STATUS_OK;
 }
 
-status_t frame_buffer_write_error_count(size_t *const size, uint8_t *const output)
+status_t frame_buffer_write_last_status(size_t *const size, uint8_t *const output)
 {
     DBC_REQUIRE(size != NULL);
     DBC_REQUIRE(output != NULL);
 
-    *size = 4;
-    endian_u32_to_network(self.write_error_count, output);
+    *size = 1;
+    output[0] = (uint8_t)self.write_last_status;
     return STATUS_OK;
 }
 
-status_t frame_buffer_write_last_status(size_t *const size, uint8_t *const output)
+status_t frame_buffer_alloc_fail_count(size_t *const size, uint8_t *const output)
 {
     DBC_REQUIRE(size != NULL);
     DBC_REQUIRE(output != NULL);
 
-    *size = 1;
-    output[0] = (uint8_t)self.read_last_status;
+    *size = 4;
+    endian_u32_to_network(self.alloc_fail_count, output);
     return STATUS_OK;
 }
@@ -0,0 +1,243 @@
+#include "app/housekeeping.h"
+
+#include "hal/uart.h"
+#include "rtos/active.h"
+#include "rtos/critical.h"
+#include "rtos/thread.h"
+#include "rtos/timer.h"
+#include "utils/dbc_assert.h"
+#include "utils/endian.h"
+#include "utils/pool.h"
+#include "utils/status.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Telemetry Handlers */
+
+status_t housekeeping_uart1_tx_pending(size_t *const size, uint8_t *const output)
+{
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(uart_tx_pending(UART1), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_uart2_tx_pending(size_t *const size, uint8_t *const output)
+{
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(uart_tx_pending(UART2), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_uart1_rx_overruns(size_t *const size, uint8_t *const output)
+{
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(uart_rx_overruns(UART1), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_cpu_load(size_t *const size, uint8_t *const output)
+{
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_cpu_load(), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_critical_max_cycles(size_t *const size, uint8_t *const output)
+{
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_critical_max_cycles(), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_load(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_load(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_jitter(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_jitter(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_overruns(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_overruns(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_timer_jitter(
+    rtos_timer_t const *const timer,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(timer != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_timer_jitter(timer), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_timer_overruns(
+    rtos_timer_t const *const timer,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(timer != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_timer_overruns(timer), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_response_min(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_response_min(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_response_max(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_response_max(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_deadline_misses(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_deadline_misses(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_response_histogram(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    uint32_t histogram[RTOS_RESPONSE_BUCKETS] = {0};
+    rtos_thread_response_histogram(thread, histogram);
+
+    *size = 0;
+    for (uint32_t i = 0U; i < RTOS_RESPONSE_BUCKETS; ++i) {
+        endian_u32_to_network(histogram[i], &output[*size]);
+        *size += 4;
+    }
+    return STATUS_OK;
+}
+
+status_t housekeeping_thread_stack_used(
+    rtos_thread_t const *const thread,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_thread_stack_used(thread), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_active_queue_max(
+    rtos_active_t const *const active,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(active != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    *size = 4;
+    endian_u32_to_network(rtos_active_queue_max(active), output);
+    return STATUS_OK;
+}
+
+status_t housekeeping_pool_usage(
+    pool_t const *const pool,
+    size_t *const size,
+    uint8_t *const output)
+{
+    DBC_REQUIRE(pool != NULL);
+    DBC_REQUIRE(size != NULL);
+    DBC_REQUIRE(output != NULL);
+
+    endian_u32_to_network(pool->count, &output[0]);
+    endian_u32_to_network(pool->used, &output[4]);
+    endian_u32_to_network(pool->used_max, &output[8]);
+    endian_u32_to_network(pool->fail_count, &output[12]);
+    *size = 16;
+    return STATUS_OK;
+}
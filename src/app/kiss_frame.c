@@ -1,6 +1,5 @@
 #include "app/kiss_frame.h"
 
-#include "utils/cbuf.h"
 #include "utils/dbc_assert.h"
 
 #include <stdbool.h>
@@ -45,60 +44,70 @@ void kiss_frame_pack(
     *output_size += 1;
 }
 
-bool kiss_frame_unpack(cbuf_t *const cbuf, size_t *const count, uint8_t *const output)
+bool kiss_frame_unpack_buf(
+    size_t const input_size,
+    uint8_t const input[input_size],
+    size_t *const consumed,
+    size_t *const count,
+    uint8_t *const output,
+    bool *const frame_esc)
 {
-    DBC_REQUIRE(cbuf != NULL);
+    DBC_REQUIRE(input != NULL);
+    DBC_REQUIRE(consumed != NULL);
     DBC_REQUIRE(count != NULL);
     DBC_REQUIRE(output != NULL);
+    DBC_REQUIRE(frame_esc != NULL);
 
+    /* The caller keeps frame_esc with count, so an escape split from the byte it escapes is still
+     * decoded */
     bool end_frame = false;
-    bool frame_esc = false;
-    while ((cbuf_size(cbuf) > 0) && (!end_frame)) {
-        uint8_t byte = 0;
-        cbuf_get(cbuf, &byte);
+    while ((*consumed < input_size) && (!end_frame)) {
+        uint8_t byte = input[*consumed];
+        *consumed += 1;
         switch (byte) {
             case KISS_FEND: {
                 /* Ignore any back to back FEND bytes (i.e. no frame data parsed yet) */
                 if (*count <= 0) {
+                    *frame_esc = false;
                     continue;
                 }
 
                 end_frame = true;
-                frame_esc = false;
+                *frame_esc = false;
                 break;
             }
             case KISS_FESC: {
                 end_frame = false;
-                frame_esc = true;
+                *frame_esc = true;
                 break;
             }
             case KISS_TFEND: {
-                if (frame_esc) {
+                if (*frame_esc) {
                     byte = KISS_FEND;
                 }
-                frame_esc = false;
+                *frame_esc = false;
                 end_frame = false;
                 break;
             }
             case KISS_TFESC: {
-                if (frame_esc) {
+                if (*frame_esc) {
                     byte = KISS_FESC;
                 }
-                frame_esc = false;
+                *frame_esc = false;
                 end_frame = false;
                 break;
             }
             default: {
                 /* parse data normally */
-                frame_esc = false;
+                *frame_esc = false;
                 end_frame = false;
                 break;
             }
         }
-        if (!frame_esc && !end_frame) {
-            if (*count >= CBUF_SIZE) {
+        if (!*frame_esc && !end_frame) {
+            if (*count >= KISS_FRAME_MAX_SIZE) {
                 /* reset packet buffer if will overflow */
-                *output = 0;
+                *count = 0;
                 return false;
             }
             /* Write byte to output buffer */
@@ -20,6 +20,13 @@ status_t telemetry_register(uint8_t id, telemetry_handler_t handler)
     return STATUS_OK;
 }
 
+status_t telemetry_retired(size_t *const size, uint8_t *const output)
+{
+    (void)size;
+    (void)output;
+    return TELEMETRY_STATUS_RETIRED_TELEMETRY_ID;
+}
+
 status_t telemetry_handler(
     size_t input_size,
     uint8_t const *const input_buffer,
@@ -0,0 +1,66 @@
+#include "app/trace.h"
+
+#include "rtos/trace.h"
+#include "utils/dbc_assert.h"
+#include "utils/endian.h"
+#include "utils/status.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+status_t trace_handler(
+    size_t input_size,
+    uint8_t const *const input_buffer,
+    size_t *const output_size,
+    uint8_t *const output_buffer)
+{
+    DBC_REQUIRE(input_buffer != NULL);
+    DBC_REQUIRE(output_size != NULL);
+    DBC_REQUIRE(output_buffer != NULL);
+    if (input_size < 1) {
+        return TRACE_STATUS_INVALID_PAYLOAD_SIZE;
+    }
+
+    *output_size = 0;
+    switch (input_buffer[0]) {
+        case TRACE_CMD_STOP: {
+            if (input_size != 1) {
+                return TRACE_STATUS_INVALID_PAYLOAD_SIZE;
+            }
+            rtos_trace_stop();
+            *output_size = 4;
+            endian_u32_to_network(rtos_trace_count(), output_buffer);
+            return STATUS_OK;
+        }
+        case TRACE_CMD_START: {
+            if (input_size != 1) {
+                return TRACE_STATUS_INVALID_PAYLOAD_SIZE;
+            }
+            rtos_trace_start();
+            return STATUS_OK;
+        }
+        case TRACE_CMD_READ: {
+            if (input_size != 5) {
+                return TRACE_STATUS_INVALID_PAYLOAD_SIZE;
+            }
+            uint32_t index = 0;
+            endian_u32_from_network(&input_buffer[1], &index);
+
+            rtos_trace_record_t record = {0};
+            if (!rtos_trace_read(index, &record)) {
+                return TRACE_STATUS_RECORD_UNAVAILABLE;
+            }
+            endian_u32_to_network(record.cycles, &output_buffer[0]);
+            output_buffer[4] = record.event;
+            output_buffer[5] = record.thread;
+            output_buffer[6] = (uint8_t)(record.arg >> 8);
+            output_buffer[7] = (uint8_t)(record.arg & 0xFF);
+            *output_size = 8;
+            return STATUS_OK;
+        }
+        default: {
+            return TRACE_STATUS_INVALID_COMMAND;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include "hal/dma.h"
+
+#include "hal/pinutils.h"
+#include "hal/rcc.h"
+#include "utils/dbc_assert.h"
+
+#include <stdint.h>
+
+/* Offset of each stream's flags within LISR/HISR (streams 0-3 in LISR, 4-7 in HISR) */
+static uint8_t const dma_flag_shift[4] = {0, 6, 16, 22};
+
+void dma_clock_enable(dma_t *const dma)
+{
+    if (dma == DMA1) {
+        RCC->AHB1ENR |= BIT(21);
+    } else {
+        DBC_REQUIRE(dma == DMA2);
+        RCC->AHB1ENR |= BIT(22);
+    }
+}
+
+void dma_stream_disable(dma_t *const dma, uint8_t const stream)
+{
+    DBC_REQUIRE(stream < 8);
+
+    dma->S[stream].CR &= ~DMA_SXCR_EN;
+    while (dma->S[stream].CR & DMA_SXCR_EN) {
+        (void)0;
+    }
+}
+
+uint32_t dma_flags_get(dma_t const *const dma, uint8_t const stream)
+{
+    DBC_REQUIRE(stream < 8);
+
+    uint32_t const isr = (stream < 4) ? dma->LISR : dma->HISR;
+    return (isr >> dma_flag_shift[stream & 0x3U]) & DMA_FLAG_ALL;
+}
+
+void dma_flags_clear(dma_t *const dma, uint8_t const stream, uint32_t const flags)
+{
+    DBC_REQUIRE(stream < 8);
+
+    uint32_t const mask = (flags & DMA_FLAG_ALL) << dma_flag_shift[stream & 0x3U];
+    if (stream < 4) {
+        dma->LIFCR = mask;
+    } else {
+        dma->HIFCR = mask;
+    }
+}
@@ -1,5 +1,7 @@
 #include "hal/stm32f4_blackpill.h"
 #include "hal/uart.h"
+#include "rtos/thread.h"
+#include "utils/debug.h"
 
 #include <stdint.h>
 
@@ -23,6 +25,11 @@ __attribute__((noreturn)) void Reset_Handler(void)
         *dst = *src;
     }
 
+    /* Enable full access to the fpu (coprocessors 10 and 11) */
+    SCB->CPACR |= (0xFU << 20U);
+    __DSB();
+    __ISB();
+
     main(); /* call main */
 
     for (;;)
@@ -34,6 +41,20 @@ void assert_failed(char const *file, int line)
     (void)line;
     uart_write_str(UART2, file);
     uart_write_str(UART2, "\r\n");
+    uart_flush(UART2);
+    NVIC_SystemReset();
+}
+
+/* Report which thread overflowed its stack into the guard region, entered from
+ * MemManage_Handler on the boot stack */
+void memmanage_fault(void)
+{
+    rtos_thread_t const *const thread = rtos_thread_self();
+    debug_int("MemManageFault: thread priority", (thread != NULL) ? thread->base_priority : 0U);
+    if (SCB->CFSR & SCB_CFSR_MMARVALID_Msk) {
+        debug_int("MemManageFault: address", SCB->MMFAR);
+    }
+    uart_flush(UART2);
     NVIC_SystemReset();
 }
 
@@ -58,6 +79,11 @@ void SysTick_Handler(void) __attribute__((weak, alias("Default_Handler")));
 void USART1_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
 void USART2_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
 void USART6_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA1_Stream6_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA2_Stream1_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA2_Stream5_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA2_Stream6_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA2_Stream7_IRQHandler(void) __attribute__((weak, alias("Default_Handler")));
 
 /* end of stack pointer */
 extern void __stack_end__(void);
@@ -100,7 +126,7 @@ __attribute__((section(".vectors"))) vector_table_t tab = {
     [30] = Default_Handler,
     [31] = Default_Handler,
     [32] = Default_Handler,
-    [33] = Default_Handler,
+    [33] = DMA1_Stream6_IRQHandler,
     [34] = Default_Handler,
     [35] = Default_Handler,
     [36] = Default_Handler,
@@ -140,7 +166,7 @@ __attribute__((section(".vectors"))) vector_table_t tab = {
     [70] = Default_Handler,
     [71] = Default_Handler,
     [72] = Default_Handler,
-    [73] = Default_Handler,
+    [73] = DMA2_Stream1_IRQHandler,
     [74] = Default_Handler,
     [75] = Default_Handler,
     [76] = Default_Handler,
@@ -151,9 +177,9 @@ __attribute__((section(".vectors"))) vector_table_t tab = {
     [81] = Default_Handler,
     [82] = Default_Handler,
     [83] = Default_Handler,
-    [84] = Default_Handler,
-    [85] = Default_Handler,
-    [86] = Default_Handler,
+    [84] = DMA2_Stream5_IRQHandler,
+    [85] = DMA2_Stream6_IRQHandler,
+    [86] = DMA2_Stream7_IRQHandler,
     [87] = USART6_IRQHandler,
     [88] = Default_Handler,
     [89] = Default_Handler,
@@ -184,13 +210,12 @@ __attribute__((naked)) void HardFault_Handler(void)
                  "    .align 2\n\t");
 }
 
-__attribute__((naked)) void MemManageFault_Handler(void)
+__attribute__((naked)) void MemManage_Handler(void)
 {
-    asm volatile("    ldr r0,=str_mem\n\t"
-                 "    mov r1,#1\n\t"
-                 "    b assert_failed\n\t"
-                 "str_mem: .asciz \"MemManageFault\"\n\t"
-                 "    .align 2\n\t");
+    /* The faulting stack is likely exhausted, so report from the (otherwise unused once the rtos
+     * is running) boot stack */
+    asm volatile("    ldr sp,=__stack_end__\n\t"
+                 "    b memmanage_fault\n\t");
 }
 
 __attribute__((naked)) void BusFault_Handler(void)
@@ -4,11 +4,17 @@
 #include "hal/rcc.h"
 #include "hal/stm32f4_blackpill.h"
 #include "hal/uart.h"
+#include "rtos/critical.h"
 #include "rtos/thread.h"
+#include "rtos/trace.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
+#define SYSTICK_CTRL_ENABLE    BIT(0)
+#define SYSTICK_CTRL_COUNTFLAG BIT(16)
+#define SYSTICK_MAX_LOAD       (0x00FFFFFFU) /* Systick timer is 24 bit */
+
 static volatile uint32_t s_ticks; /* tick counter */
 
 void systick_init(uint32_t const ticks)
@@ -50,11 +56,78 @@ void rtos_on_startup(void)
 {
     /* tick every ms */
     systick_init(CLOCK_FREQ / 1000);
+    /* The tick calls into the rtos, so must be masked by its critical sections */
+    NVIC_SetPriority(SysTick_IRQn, RTOS_KERNEL_IRQ_PRIORITY);
+}
+
+#if SYSTICK_TICKLESS
+/* Sleep with the tick stopped until the next thread is due or another interrupt wakes the core,
+ * then account for the ticks slept through */
+static void systick_tickless_idle(void)
+{
+    /* Masks all interrupts rather than entering a critical section, as WFI doesn't wake on
+     * interrupts masked by BASEPRI */
+    disable_irq();
+
+    uint32_t idle_ticks = rtos_idle_ticks();
+    uint32_t const period = SYSTICK->LOAD + 1U;
+    if (idle_ticks > (SYSTICK_MAX_LOAD / period)) {
+        idle_ticks = SYSTICK_MAX_LOAD / period;
+    }
+    /* Not worth stopping the tick if the next one is due anyway */
+    if (idle_ticks <= 1U) {
+        __WFI();
+        enable_irq();
+        return;
+    }
+
+    /* Stop the tick and extend the current tick period to the wake-up time */
+    uint32_t ctrl = SYSTICK->CTRL;
+    SYSTICK->CTRL = ctrl & ~SYSTICK_CTRL_ENABLE;
+    uint32_t const remaining = SYSTICK->VAL;
+    SYSTICK->LOAD = remaining + ((idle_ticks - 1U) * period) - 1U;
+    SYSTICK->VAL = 0U;
+    SYSTICK->CTRL = ctrl;
+
+    /* WFI wakes on a pending interrupt even while masked, which is serviced once re-enabled */
+    __DSB();
+    __WFI();
+
+    /* Reading CTRL clears the count flag */
+    ctrl = SYSTICK->CTRL;
+    SYSTICK->CTRL = ctrl & ~SYSTICK_CTRL_ENABLE;
+
+    uint32_t elapsed_ticks = 0U;
+    if (ctrl & SYSTICK_CTRL_COUNTFLAG) {
+        /* Slept until the wake-up time, the pending SysTick interrupt counts the final tick */
+        elapsed_ticks = idle_ticks - 1U;
+        SYSTICK->LOAD = period - 1U;
+        SYSTICK->VAL = 0U;
+    } else {
+        /* Woken early by another interrupt, count the whole ticks slept through and finish the
+         * partial one before restoring the tick period */
+        uint32_t const counted = (SYSTICK->LOAD + 1U - SYSTICK->VAL) + (period - remaining);
+        elapsed_ticks = counted / period;
+        SYSTICK->LOAD = period - (counted % period) - 1U;
+        SYSTICK->VAL = 0U;
+    }
+    SYSTICK->CTRL = ctrl & ~SYSTICK_CTRL_COUNTFLAG;
+    /* Takes effect on the next reload */
+    SYSTICK->LOAD = period - 1U;
+
+    s_ticks += elapsed_ticks;
+    rtos_tick_advance(elapsed_ticks);
+    rtos_schedule();
+
+    enable_irq();
 }
+#endif
 
 void rtos_on_idle(void)
 {
-#if 0
+#if SYSTICK_TICKLESS
+    systick_tickless_idle();
+#elif 0
     /* Wait for interrupt (not sure if this works with unicorn) */
     __WFI();
 #else
@@ -64,10 +137,12 @@ void rtos_on_idle(void)
 
 void SysTick_Handler(void)
 {
+    RTOS_TRACE_ISR_ENTER();
     s_ticks++;
     rtos_tick();
 
-    disable_irq();
+    uint32_t const basepri = rtos_critical_enter();
     rtos_schedule();
-    enable_irq();
+    rtos_critical_exit(basepri);
+    RTOS_TRACE_ISR_EXIT();
 }
@@ -1,11 +1,17 @@
 #include "hal/uart.h"
 
+#include "hal/dma.h"
 #include "hal/gpio.h"
 #include "hal/pinutils.h"
 #include "hal/stm32f4_blackpill.h"
 #include "hal/systick.h"
+#include "rtos/critical.h"
+#include "rtos/trace.h"
+#include "rtos/work.h"
 #include "utils/cbuf.h"
 #include "utils/dbc_assert.h"
+#include "utils/spsc.h"
+#include "utils/status.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -23,51 +29,325 @@ static IRQn_Type const uart_irq_map[3] = {
     [UART6] = USART6_IRQn,
 };
 
-static cbuf_t uart_buf_map[3] = {
+/* Receive rings, filled by the uart or rx dma isr and drained by a single reader */
+static uint8_t uart1_rx_storage[UART1_RX_SIZE] = {0};
+static uint8_t uart2_rx_storage[UART2_RX_SIZE] = {0};
+static uint8_t uart6_rx_storage[UART6_RX_SIZE] = {0};
+
+/* Transmit queue storage */
+static uint8_t uart1_tx_storage[UART1_TX_SIZE] = {0};
+static uint8_t uart2_tx_storage[UART2_TX_SIZE] = {0};
+static uint8_t uart6_tx_storage[UART6_TX_SIZE] = {0};
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;
+} uart_storage_t;
+
+static uart_storage_t const uart_rx_storage_map[3] = {
+    [UART1] = {.buf = uart1_rx_storage, .size = UART1_RX_SIZE},
+    [UART2] = {.buf = uart2_rx_storage, .size = UART2_RX_SIZE},
+    [UART6] = {.buf = uart6_rx_storage, .size = UART6_RX_SIZE},
+};
+
+static uart_storage_t const uart_tx_storage_map[3] = {
+    [UART1] = {.buf = uart1_tx_storage, .size = UART1_TX_SIZE},
+    [UART2] = {.buf = uart2_tx_storage, .size = UART2_TX_SIZE},
+    [UART6] = {.buf = uart6_tx_storage, .size = UART6_TX_SIZE},
+};
+
+static spsc_t uart_rx_map[3] = {
     [UART1] = {0},
     [UART2] = {0},
     [UART6] = {0},
 };
 
+/* Work to submit when data is received */
+static rtos_work_t *uart_rx_work_map[3] = {
+    [UART1] = NULL,
+    [UART2] = NULL,
+    [UART6] = NULL,
+};
+
+/* DMA streams used to receive into the rx rings (USART1_RX: DMA2 stream 5 channel 4,
+ * USART6_RX: DMA2 stream 1 channel 5) */
+typedef struct {
+    dma_t *dma;
+    uint8_t stream;
+    uint8_t channel;
+    IRQn_Type irq;
+} uart_dma_t;
+
+static uart_dma_t const uart_rx_dma_map[3] = {
+    [UART1] = {.dma = DMA2, .stream = 5, .channel = 4, .irq = DMA2_Stream5_IRQn},
+    [UART2] = {0}, /* Not supported */
+    [UART6] = {.dma = DMA2, .stream = 1, .channel = 5, .irq = DMA2_Stream1_IRQn},
+};
+
+/* DMA streams used to transmit async buffers (USART1_TX: DMA2 stream 7 channel 4, USART2_TX:
+ * DMA1 stream 6 channel 4, USART6_TX: DMA2 stream 6 channel 5) */
+static uart_dma_t const uart_tx_dma_map[3] = {
+    [UART1] = {.dma = DMA2, .stream = 7, .channel = 4, .irq = DMA2_Stream7_IRQn},
+    [UART2] = {.dma = DMA1, .stream = 6, .channel = 4, .irq = DMA1_Stream6_IRQn},
+    [UART6] = {.dma = DMA2, .stream = 6, .channel = 5, .irq = DMA2_Stream6_IRQn},
+};
+
+typedef struct {
+    uint8_t const *buf;
+    uint32_t size;
+    uart_tx_done_t done;
+    size_t fence; /* tx cbuf write index when queued, bytes queued before it are sent first */
+} uart_tx_desc_t;
+
+/* Transmit state. Bytes from uart_write_* go in the cbuf and are drained by the TXE interrupt,
+ * buffers from uart_write_buf_async are sent by dma in the order they were queued */
+typedef struct {
+    cbuf_t cbuf;
+    uart_tx_desc_t desc[UART_TX_DESC_COUNT];
+    uint32_t desc_head;
+    uint32_t desc_count;
+    bool dma_busy;
+} uart_tx_t;
+
+static uart_tx_t uart_tx_map[3] = {0};
+
+/* Mask interrupts, returning the previous mask so the calls can be nested (i.e. from the
+ * DBC fault handler) */
+static inline uint32_t uart_lock(void)
+{
+    uint32_t const primask = __get_PRIMASK();
+    disable_irq();
+    return primask;
+}
+
+static inline void uart_unlock(uint32_t const primask) { __set_PRIMASK(primask); }
+
 /* USART IRQ Handlers */
 
-/* Static inline cbuf function */
-static inline void cbuf_isr_put(cbuf_t *const self, uint8_t const value)
+/* Publish the bytes the dma has written into the ring by moving its head up to the dma's
+ * position. NDTR counts down from the ring's size and reloads in circular mode. The dma doesn't
+ * wait for the reader, but the half and full transfer interrupts move the head at least every
+ * half lap, so spsc_read (with the ring's lag set to half of it) catches a reader that has
+ * fallen far enough behind for the dma to reach it */
+static inline void uart_dma_rx_update(
+    dma_t const *const dma,
+    uint8_t const stream,
+    spsc_t *const rx)
+{
+    spsc_produce_to(rx, ((rx->mask + 1U) - dma->S[stream].NDTR) & rx->mask);
+}
+
+static inline void uart_rx_signal(uart_id_t const uart_id)
 {
-    if (((self->write + 1) % CBUF_SIZE) != self->read) {
-        self->buf[self->write] = value;
-        self->write = (self->write + 1) % CBUF_SIZE;
+    if (uart_rx_work_map[uart_id] != NULL) {
+        (void)rtos_work_submit(uart_rx_work_map[uart_id]);
+    }
+}
+
+static inline void uart_read_isr(uart_id_t const uart_id, spsc_t *const rx)
+{
+    uart_t *const uart = uart_map[uart_id];
+
+    /* receive register not empty (bit 5 is SR->RXNE) and RXNE interrupt enabled (bit 5 is
+     * CR1->RXNEIE), in dma mode the dma consumes the data register */
+    if ((uart->CR1 & BIT(5)) && (uart->SR & BIT(5))) {
+        /* Copy byte into the ring, dropped if the reader has fallen behind */
+        (void)spsc_put(rx, (uint8_t)(uart->DR & 0xFF));
+        uart_rx_signal(uart_id);
+    }
+
+    /* idle line detected (bit 4 is SR->IDLE) and IDLE interrupt enabled (bit 4 is CR1->IDLEIE),
+     * marks the end of a burst of data received by the dma */
+    if ((uart->CR1 & BIT(4)) && (uart->SR & BIT(4))) {
+        uart_dma_t const *const rx_dma = &uart_rx_dma_map[uart_id];
+        /* IDLE is cleared by reading SR followed by DR */
+        (void)uart->DR;
+        uart_dma_rx_update(rx_dma->dma, rx_dma->stream, rx);
+        uart_rx_signal(uart_id);
+    }
+}
+
+static inline void uart_dma_rx_isr(uart_id_t const uart_id, spsc_t *const rx)
+{
+    uart_dma_t const *const rx_dma = &uart_rx_dma_map[uart_id];
+    uint32_t const flags = dma_flags_get(rx_dma->dma, rx_dma->stream);
+    dma_flags_clear(rx_dma->dma, rx_dma->stream, flags);
+
+    /* Half and full transfer flags keep the ring up to date during long bursts, before the dma
+     * wraps around the buffer */
+    if (flags & (DMA_FLAG_HT | DMA_FLAG_TC)) {
+        uart_dma_rx_update(rx_dma->dma, rx_dma->stream, rx);
+        uart_rx_signal(uart_id);
+    }
+}
+
+/* Index in the tx cbuf up to which bytes can be sent before the next dma buffer */
+static inline size_t uart_tx_fence(uart_tx_t const *const tx)
+{
+    if (tx->desc_count > 0) {
+        return tx->desc[tx->desc_head].fence;
+    }
+    return tx->cbuf.write;
+}
+
+/* Start the next transfer, requires interrupts be disabled (or called from the uart/dma isr).
+ * Bytes queued ahead of the next dma buffer are drained by the TXE interrupt first */
+static void uart_tx_kick(uart_id_t const uart_id)
+{
+    uart_t *const uart = uart_map[uart_id];
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+
+    if (tx->dma_busy) {
+        return;
+    }
+    if (tx->cbuf.read != uart_tx_fence(tx)) {
+        uart->CR1 |= BIT(7); /* TXEIE */
+        return;
+    }
+    uart->CR1 &= ~BIT(7); /* TXEIE */
+    if (tx->desc_count == 0) {
+        return;
+    }
+
+    uart_dma_t const *const tx_dma = &uart_tx_dma_map[uart_id];
+    uart_tx_desc_t const *const desc = &tx->desc[tx->desc_head];
+    dma_stream_t *const stream = &tx_dma->dma->S[tx_dma->stream];
+
+    tx->dma_busy = true;
+    dma_flags_clear(tx_dma->dma, tx_dma->stream, DMA_FLAG_ALL);
+    stream->M0AR = (uint32_t)desc->buf;
+    stream->NDTR = desc->size;
+    /* Clear TC by writing 0 (bit 6 is SR->TC), writing 1 to the other bits has no effect */
+    uart->SR = ~BIT(6);
+    stream->CR |= DMA_SXCR_EN;
+    uart->CR3 |= BIT(7); /* DMAT */
+}
+
+/* Retire the dma buffer in flight and start the next transfer, requires interrupts be disabled.
+ * Returns the retired buffer, its done callback must be called once interrupts are restored */
+static uart_tx_desc_t uart_tx_dma_complete(uart_id_t const uart_id)
+{
+    uart_dma_t const *const tx_dma = &uart_tx_dma_map[uart_id];
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+    uart_tx_desc_t const desc = tx->desc[tx->desc_head];
+
+    dma_flags_clear(tx_dma->dma, tx_dma->stream, DMA_FLAG_ALL);
+    uart_map[uart_id]->CR3 &= ~BIT(7); /* DMAT */
+    tx->desc_head = (tx->desc_head + 1) % UART_TX_DESC_COUNT;
+    tx->desc_count--;
+    tx->dma_busy = false;
+    uart_tx_kick(uart_id);
+    return desc;
+}
+
+/* Hand a retired buffer back to its owner. Called without the uart lock held, the callback may
+ * take the rtos paths which must not run with the zero-latency band masked */
+static inline void uart_tx_done(uart_tx_desc_t const *const desc)
+{
+    if (desc->done != NULL) {
+        desc->done(desc->buf);
+    }
+}
+
+static inline void uart_write_isr(uart_id_t const uart_id)
+{
+    uart_t *const uart = uart_map[uart_id];
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+
+    /* transmit register empty (bit 7 is SR->TXE) and TXE interrupt enabled (bit 7 is CR1->TXEIE) */
+    if ((uart->CR1 & BIT(7)) && (uart->SR & BIT(7))) {
+        uint8_t byte = 0;
+        if ((tx->cbuf.read != uart_tx_fence(tx)) && (cbuf_get(&tx->cbuf, &byte) == STATUS_OK)) {
+            uart->DR = byte;
+        } else {
+            /* Reached the next dma buffer, or nothing left to send */
+            uart_tx_kick(uart_id);
+        }
     }
 }
 
-static inline void uart_read_isr(uart_t *const uart, cbuf_t *const cbuf)
+static inline void uart_dma_tx_isr(uart_id_t const uart_id)
 {
-    /* receive register not empty (bit 5 is SR->RXNE) */
-    if (uart->SR & BIT(5)) {
-        /* Copy byte into cbuf */
-        cbuf_isr_put(cbuf, (uart->DR & 0xFF));
+    uart_dma_t const *const tx_dma = &uart_tx_dma_map[uart_id];
+
+    /* The uart isr (in the zero-latency band) shares the tx state and can preempt this one */
+    uart_tx_desc_t retired = {0};
+    uint32_t const primask = uart_lock();
+    uint32_t const flags = dma_flags_get(tx_dma->dma, tx_dma->stream);
+
+    /* A transfer error drops the buffer rather than stalling the queue */
+    if (flags & (DMA_FLAG_TC | DMA_FLAG_TE)) {
+        retired = uart_tx_dma_complete(uart_id);
+    } else {
+        dma_flags_clear(tx_dma->dma, tx_dma->stream, flags);
     }
+    uart_unlock(primask);
+
+    uart_tx_done(&retired);
 }
 
 void USART1_IRQHandler(void)
 {
-    static cbuf_t *const cbuf = &uart_buf_map[UART1];
-    static uart_t *const uart = uart_map[UART1];
-    uart_read_isr(uart, cbuf);
+    static spsc_t *const rx = &uart_rx_map[UART1];
+    RTOS_TRACE_ISR_ENTER();
+    uart_read_isr(UART1, rx);
+    uart_write_isr(UART1);
+    RTOS_TRACE_ISR_EXIT();
 }
 
 void USART2_IRQHandler(void)
 {
-    static cbuf_t *const cbuf = &uart_buf_map[UART2];
-    static uart_t *const uart = uart_map[UART2];
-    uart_read_isr(uart, cbuf);
+    static spsc_t *const rx = &uart_rx_map[UART2];
+    RTOS_TRACE_ISR_ENTER();
+    uart_read_isr(UART2, rx);
+    uart_write_isr(UART2);
+    RTOS_TRACE_ISR_EXIT();
 }
 
 void USART6_IRQHandler(void)
 {
-    static cbuf_t *const cbuf = &uart_buf_map[UART6];
-    static uart_t *const uart = uart_map[UART6];
-    uart_read_isr(uart, cbuf);
+    static spsc_t *const rx = &uart_rx_map[UART6];
+    RTOS_TRACE_ISR_ENTER();
+    uart_read_isr(UART6, rx);
+    uart_write_isr(UART6);
+    RTOS_TRACE_ISR_EXIT();
+}
+
+/* DMA IRQ Handlers */
+
+void DMA2_Stream1_IRQHandler(void)
+{
+    RTOS_TRACE_ISR_ENTER();
+    uart_dma_rx_isr(UART6, &uart_rx_map[UART6]);
+    RTOS_TRACE_ISR_EXIT();
+}
+
+void DMA2_Stream5_IRQHandler(void)
+{
+    RTOS_TRACE_ISR_ENTER();
+    uart_dma_rx_isr(UART1, &uart_rx_map[UART1]);
+    RTOS_TRACE_ISR_EXIT();
+}
+
+void DMA1_Stream6_IRQHandler(void)
+{
+    RTOS_TRACE_ISR_ENTER();
+    uart_dma_tx_isr(UART2);
+    RTOS_TRACE_ISR_EXIT();
+}
+
+void DMA2_Stream6_IRQHandler(void)
+{
+    RTOS_TRACE_ISR_ENTER();
+    uart_dma_tx_isr(UART6);
+    RTOS_TRACE_ISR_EXIT();
+}
+
+void DMA2_Stream7_IRQHandler(void)
+{
+    RTOS_TRACE_ISR_ENTER();
+    uart_dma_tx_isr(UART1);
+    RTOS_TRACE_ISR_EXIT();
 }
 
 void uart_init(uart_id_t const uart_id, uint32_t const baud)
@@ -100,6 +380,14 @@ void uart_init(uart_id_t const uart_id, uint32_t const baud)
         }
     }
 
+    uart_storage_t const *const rx_storage = &uart_rx_storage_map[uart_id];
+    uart_storage_t const *const tx_storage = &uart_tx_storage_map[uart_id];
+    spsc_init(&uart_rx_map[uart_id], rx_storage->buf, rx_storage->size);
+    cbuf_init(&uart_tx_map[uart_id].cbuf, tx_storage->buf, tx_storage->size);
+    uart_tx_map[uart_id].desc_head = 0;
+    uart_tx_map[uart_id].desc_count = 0;
+    uart_tx_map[uart_id].dma_busy = false;
+
     gpio_set_mode(tx, GPIO_MODE_AF);
     gpio_set_af(tx, af);
     gpio_set_mode(rx, GPIO_MODE_AF);
@@ -113,11 +401,67 @@ void uart_init(uart_id_t const uart_id, uint32_t const baud)
     /* uart enable, receive enable, transmit enable, receive interrupt enable (RXNEIE) */
     uart_map[uart_id]->CR1 |= BIT(13) | BIT(3) | BIT(2) | BIT(5);
 
-    /* Setup UART NVIC */
+    /* Setup UART NVIC. The uart (and rx dma) isrs only signal the rx thread, so they run in the
+     * rtos zero-latency band and reception is never held off by rtos critical sections */
     NVIC_SetPriorityGrouping(0);
     uint32_t uart_pri_encoding = NVIC_EncodePriority(0, 1, 0);
     NVIC_SetPriority(uart_irq_map[uart_id], uart_pri_encoding);
     NVIC_EnableIRQ(uart_irq_map[uart_id]);
+
+    /* Memory to peripheral transfers from async buffers into DR, the address and size are set
+     * per transfer */
+    uart_dma_t const *const tx_dma = &uart_tx_dma_map[uart_id];
+    dma_stream_t *const stream = &tx_dma->dma->S[tx_dma->stream];
+    dma_clock_enable(tx_dma->dma);
+    dma_stream_disable(tx_dma->dma, tx_dma->stream);
+    stream->PAR = (uint32_t)&uart_map[uart_id]->DR;
+    stream->FCR = 0; /* direct mode */
+    stream->CR = DMA_SXCR_CHSEL(tx_dma->channel) | DMA_SXCR_MINC | DMA_SXCR_DIR_M2P | DMA_SXCR_TCIE
+                 | DMA_SXCR_TEIE;
+    /* Completion callbacks may call the rtos (e.g. to give a semaphore), so the tx dma isr must
+     * be masked by rtos critical sections */
+    NVIC_SetPriority(tx_dma->irq, RTOS_KERNEL_IRQ_PRIORITY);
+    NVIC_EnableIRQ(tx_dma->irq);
+}
+
+void uart_rx_dma_enable(uart_id_t const uart_id)
+{
+    uart_dma_t const *const rx_dma = &uart_rx_dma_map[uart_id];
+    DBC_REQUIRE(rx_dma->dma != NULL);
+
+    uart_t *const uart = uart_map[uart_id];
+    spsc_t *const rx = &uart_rx_map[uart_id];
+    dma_stream_t *const stream = &rx_dma->dma->S[rx_dma->stream];
+
+    /* Stop interrupt driven reception, the dma fills the ring's storage from the start */
+    NVIC_DisableIRQ(uart_irq_map[uart_id]);
+    uart->CR1 &= ~BIT(5); /* RXNEIE */
+    uart_storage_t const *const rx_storage = &uart_rx_storage_map[uart_id];
+    spsc_init(rx, rx_storage->buf, rx_storage->size);
+    /* The dma runs up to half the ring past the head published by the last half/full transfer
+     * interrupt */
+    spsc_set_lag(rx, rx_storage->size / 2U);
+
+    /* Circular peripheral to memory transfer of bytes from DR into the ring */
+    dma_clock_enable(rx_dma->dma);
+    dma_stream_disable(rx_dma->dma, rx_dma->stream);
+    dma_flags_clear(rx_dma->dma, rx_dma->stream, DMA_FLAG_ALL);
+    stream->PAR = (uint32_t)&uart->DR;
+    stream->M0AR = (uint32_t)&rx->buf[0];
+    stream->NDTR = rx_storage->size;
+    stream->FCR = 0; /* direct mode */
+    stream->CR = DMA_SXCR_CHSEL(rx_dma->channel) | DMA_SXCR_MINC | DMA_SXCR_CIRC | DMA_SXCR_DIR_P2M
+                 | DMA_SXCR_HTIE | DMA_SXCR_TCIE;
+
+    NVIC_SetPriority(rx_dma->irq, NVIC_GetPriority(uart_irq_map[uart_id]));
+    NVIC_EnableIRQ(rx_dma->irq);
+    stream->CR |= DMA_SXCR_EN;
+
+    /* dma receive enable (bit 6 is CR3->DMAR), idle line interrupt enable (bit 4 is
+     * CR1->IDLEIE) */
+    uart->CR3 |= BIT(6);
+    uart->CR1 |= BIT(4);
+    NVIC_EnableIRQ(uart_irq_map[uart_id]);
 }
 
 bool uart_read_ready(uart_id_t const uart_id)
@@ -134,10 +478,104 @@ static inline void spin(volatile uint32_t count)
     }
 }
 
+/* Make progress on the transmit queue without the uart/dma interrupts, used when they can't
+ * run (queue full, or interrupts masked by the caller). Requires interrupts be disabled,
+ * returns the buffer it retired (if any) for uart_tx_done */
+static uart_tx_desc_t uart_tx_poll(uart_id_t const uart_id)
+{
+    uart_t *const uart = uart_map[uart_id];
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+    uart_dma_t const *const tx_dma = &uart_tx_dma_map[uart_id];
+    uart_tx_desc_t retired = {0};
+
+    if (tx->dma_busy) {
+        if (dma_flags_get(tx_dma->dma, tx_dma->stream) & (DMA_FLAG_TC | DMA_FLAG_TE)) {
+            retired = uart_tx_dma_complete(uart_id);
+        }
+        return retired;
+    }
+
+    uint8_t byte = 0;
+    if (tx->cbuf.read != uart_tx_fence(tx)) {
+        if ((uart->SR & BIT(7)) && (cbuf_get(&tx->cbuf, &byte) == STATUS_OK)) {
+            uart->DR = byte;
+        }
+    } else {
+        uart_tx_kick(uart_id);
+    }
+    return retired;
+}
+
 void uart_write_byte(uart_id_t const uart_id, uint8_t const byte)
 {
-    uart_map[uart_id]->DR = byte;
-    while ((uart_map[uart_id]->SR & BIT(7)) == 0) {
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+
+    for (;;) {
+        uint32_t const primask = uart_lock();
+        if (cbuf_put(&tx->cbuf, byte) == STATUS_OK) {
+            uart_tx_kick(uart_id);
+            uart_unlock(primask);
+            return;
+        }
+        /* Queue is full, make room by feeding the uart directly */
+        uart_tx_desc_t const retired = uart_tx_poll(uart_id);
+        uart_unlock(primask);
+        uart_tx_done(&retired);
+        spin(1);
+    }
+}
+
+status_t uart_write_buf_async(
+    uart_id_t const uart_id,
+    uint32_t const size,
+    uint8_t const buf[size],
+    uart_tx_done_t const done)
+{
+    DBC_REQUIRE(size > 0U);
+    DBC_REQUIRE(size <= 0xFFFFU); /* NDTR is 16 bits */
+    DBC_REQUIRE(buf != NULL);
+
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+
+    uint32_t const primask = uart_lock();
+    if (tx->desc_count >= UART_TX_DESC_COUNT) {
+        uart_unlock(primask);
+        return UART_STATUS_TX_QUEUE_FULL;
+    }
+    uint32_t const idx = (tx->desc_head + tx->desc_count) % UART_TX_DESC_COUNT;
+    tx->desc[idx] = (uart_tx_desc_t){
+        .buf = buf,
+        .size = size,
+        .done = done,
+        .fence = tx->cbuf.write,
+    };
+    tx->desc_count++;
+    uart_tx_kick(uart_id);
+    uart_unlock(primask);
+    return STATUS_OK;
+}
+
+uint32_t uart_tx_pending(uart_id_t const uart_id) { return uart_tx_map[uart_id].desc_count; }
+
+uint32_t uart_rx_overruns(uart_id_t const uart_id) { return spsc_overruns(&uart_rx_map[uart_id]); }
+
+void uart_flush(uart_id_t const uart_id)
+{
+    uart_t *const uart = uart_map[uart_id];
+    uart_tx_t *const tx = &uart_tx_map[uart_id];
+
+    for (;;) {
+        uint32_t const primask = uart_lock();
+        if ((cbuf_size(&tx->cbuf) == 0) && (tx->desc_count == 0)) {
+            uart_unlock(primask);
+            break;
+        }
+        uart_tx_desc_t const retired = uart_tx_poll(uart_id);
+        uart_unlock(primask);
+        uart_tx_done(&retired);
+    }
+    /* Wait for the final byte to leave the shift register (bit 6 is SR->TC) */
+    while ((uart->SR & BIT(6)) == 0) {
         spin(1);
     }
 }
@@ -185,4 +623,9 @@ void uart_write_hex_buf(uart_id_t const uart_id, uint32_t const size, uint8_t co
     uart_write_byte(uart_id, '\n');
 }
 
-cbuf_t *uart_cbuf_get(uart_id_t const uart_id) { return &uart_buf_map[uart_id]; }
+void uart_rx_notify(uart_id_t const uart_id, rtos_work_t *const work)
+{
+    uart_rx_work_map[uart_id] = work;
+}
+
+spsc_t *uart_rx_get(uart_id_t const uart_id) { return &uart_rx_map[uart_id]; }
@@ -1,5 +1,6 @@
 #include "app/action.h"
 #include "app/frame_buffer.h"
+#include "app/housekeeping.h"
 #include "app/kiss_frame.h"
 #include "app/parameter.h"
 #include "app/spacepacket.h"
@@ -9,11 +10,17 @@
 #include "hal/stm32f4_blackpill.h"
 #include "hal/systick.h"
 #include "hal/uart.h"
+#include "rtos/active.h"
+#include "rtos/event.h"
+#include "rtos/hsm.h"
 #include "rtos/thread.h"
-#include "utils/cbuf.h"
+#include "rtos/timer.h"
+#include "rtos/work.h"
 #include "utils/dbc_assert.h"
 #include "utils/debug.h"
 #include "utils/endian.h"
+#include "utils/pool.h"
+#include "utils/spsc.h"
 #include "utils/status.h"
 #include "utils/utils.h"
 
@@ -24,143 +31,316 @@
 /**
  * RTOS Threads
  * - Idle Thread
- * - Blink LED
- * - Read from UART
- * - Process Space Packets
- * - Zig thread
+ * - Blinky Thread (Blink LED, periodic with rtos_delay_until)
+ * - Timer Thread (Zig timer)
+ * - Work Thread (Read from UART)
+ * - Packet Active Object (Process Space Packets)
  */
 
 
 /**
- * Priorities must be unique, and in the range 1..32
+ * Priorities are in the range 1..RTOS_PRIORITY_COUNT - 1, threads may share a priority
  * Higher values are higher priority
  */
-#define BLINKY_THREAD_PRIORITY   (1)
-#define UART_THREAD_PRIORITY   (5)
+#define TIMER_THREAD_PRIORITY   (6)
+#define WORK_THREAD_PRIORITY   (5)
 #define PACKET_THREAD_PRIORITY   (2)
-#define ZIG_THREAD_PRIORITY   (3)
+#define BLINKY_THREAD_PRIORITY   (1)
 
-#define IDLE_THREAD_STACK_SIZE   (40)
-#define BLINKY_STACK_SIZE        (512)
+#define IDLE_THREAD_STACK_SIZE   (128)
+#define BLINKY_THREAD_STACK_SIZE (192)
 #define PACKET_THREAD_STACK_SIZE (2048)
-#define UART_STACK_SIZE          (512)
-#define ZIG_STACK_SIZE (2048)
+/* Room for every frame and a tx done for every output frame, so neither is ever dropped */
+#define PACKET_QUEUE_LEN         (FRAME_BUFFER_COUNT + OUTPUT_FRAME_COUNT)
 
-/* Idle Thread */
-uint32_t idle_thread_stack[IDLE_THREAD_STACK_SIZE] = {0};
+/* A received frame should be handled within 10 ms, monitored to check the packet thread keeps up
+ * with the uart when preempted by the higher priority threads */
+#define PACKET_THREAD_DEADLINE (CLOCK_FREQ / 100)
 
-/* Blinky Thread */
-rtos_thread_t blinky_thread = {0};
-uint32_t blinky_stack[BLINKY_STACK_SIZE] = {0};
+#define BLINKY_PERIOD (500) /* Toggle LEDs every 500 ms */
 
-/* Packet Thread */
-rtos_thread_t packet_thread = {0};
-uint32_t packet_thread_stack[PACKET_THREAD_STACK_SIZE] = {0};
+/* Idle Thread */
+RTOS_THREAD_STACK(idle_thread_stack, IDLE_THREAD_STACK_SIZE);
 
-/* UART Thread */
-rtos_thread_t uart_thread = {0};
-uint32_t uart_stack[UART_STACK_SIZE] = {0};
+/**
+ * Size classes for pool_alloc
+ * - Responses, built by spacepacket_process and freed once KISS encoded, or held until an output
+ *   frame is free
+ * - Output frames, held until transmitted by dma so up to UART_TX_DESC_COUNT can be queued
+ */
+#define RESPONSE_SIZE       (SPACEPACKET_HDR_SIZE + SPACEPACKET_DATA_MAX_SIZE)
+#define RESPONSE_COUNT      (4)
+#define OUTPUT_FRAME_SIZE   (RESPONSE_SIZE * 2)
+#define OUTPUT_FRAME_COUNT  (UART_TX_DESC_COUNT)
+
+/* Packet Active Object, handles the frames received by the uart */
+enum {
+    FRAME_SIG = RTOS_USER_SIG, /* frame_t */
+    TX_DONE_SIG,               /* An output frame has been transmitted */
+};
 
-/* Zig Thread */
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+} response_t;
+
+typedef struct {
+    rtos_active_t super;
+    size_t packet_size; /* Deframed so far, packets can span frames */
+    bool packet_esc;    /* The last frame ended on an escape */
+    uint8_t packet_buffer[KISS_FRAME_MAX_SIZE];
+    /* Responses waiting for an output frame, oldest first */
+    response_t pending[RESPONSE_COUNT];
+    uint32_t pending_head;
+    uint32_t pending_count;
+} packet_ao_t;
+
+static packet_ao_t packet_ao = {0};
+static rtos_event_t const *packet_queue[PACKET_QUEUE_LEN];
+#define PACKET_THREAD (&packet_ao.super.thread)
+RTOS_THREAD_STACK(packet_thread_stack, PACKET_THREAD_STACK_SIZE);
+
+/* UART receive work, run by the work thread */
+static rtos_work_t uart_rx_work = {0};
+
+/* Zig, starts its own timer */
 extern void zig_main(void);
-rtos_thread_t zig_thread = {0};
-uint32_t zig_thread_stack[ZIG_STACK_SIZE] = {0};
+extern rtos_timer_t zig_timer;
+
+/* Blinky Thread, kept as a periodic thread so its release jitter is monitored */
+static rtos_thread_t blinky_thread = {0};
+RTOS_THREAD_STACK(blinky_thread_stack, BLINKY_THREAD_STACK_SIZE);
 
-void blinky_handler(void)
+static void blinky_handler(void)
 {
-    /* Setup Blinky */
-    uint16_t led = PIN('C', 13);
+    uint16_t const led = PIN('C', 13);
     gpio_set_mode(led, GPIO_MODE_OUTPUT);
-    uint32_t timer = 0;
-    uint32_t period = 500; /* Toggle LEDs every 500 ms */
+    uint32_t last_wake = rtos_tick_count();
+    bool on = true;
 
-    /* Loop */
     for (;;) {
-        if (systick_timer_expired(&timer, period, systick_get_ticks())) {
-            static bool on = true;
-            gpio_write(led, on);
-            debug_str(on ? "tick" : "tock");
-            on = !on;
-        }
-        rtos_delay(1);
+        rtos_delay_until(&last_wake, BLINKY_PERIOD);
+        gpio_write(led, on);
+        debug_str(on ? "tick" : "tock");
+        on = !on;
     }
 }
 
-void packet_thread_handler(void)
+static POOL_STORAGE(response_storage, RESPONSE_SIZE, RESPONSE_COUNT);
+static pool_t response_pool = {0};
+static POOL_STORAGE(output_frame_storage, OUTPUT_FRAME_SIZE, OUTPUT_FRAME_COUNT);
+static pool_t output_frame_pool = {0};
+
+/* Posted by the tx dma isr (at the kernel's priority) for every transmitted output frame */
+static rtos_event_t const tx_done_event = {.sig = TX_DONE_SIG, .refs = 0, .pool = NULL};
+
+static void output_frame_done(uint8_t const *const buf)
 {
-    bool packet_complete = false;
-    size_t packet_size = 0;
-    uint8_t packet_buffer[CBUF_SIZE] = {0};
-    cbuf_t kiss_frame_cbuf = {0};
-    cbuf_init(&kiss_frame_cbuf);
+    pool_free((void *)buf);
+    (void)rtos_active_post(&packet_ao.super, &tx_done_event);
+}
 
-    /* recieve a buffer of data in a queue and process it */
-    for (;;) {
-        status_t status = frame_buffer_read(&kiss_frame_cbuf);
-        if (status != STATUS_OK) {
-            DEBUG("Error reading frame buffer", status);
-        }
+/* Encode a response into an output frame and queue it for transmission, returns false (keeping
+ * the response) if every output frame is still being transmitted */
+static bool packet_transmit(response_t const *const response)
+{
+    /* From the output frame class only, so a free output frame always exists while none are
+     * being transmitted */
+    uint8_t *const output_frame_buffer = pool_block_alloc(&output_frame_pool);
+    if (output_frame_buffer == NULL) {
+        return false;
+    }
+    size_t output_frame_size = 0;
+    kiss_frame_pack(response->size, response->buf, &output_frame_size, output_frame_buffer);
+    pool_free(response->buf);
+
+    /* The frame is freed by the tx done callback */
+    status_t const status =
+        uart_write_buf_async(UART1, output_frame_size, output_frame_buffer, output_frame_done);
+    if (status != STATUS_OK) {
+        pool_free(output_frame_buffer);
+        DEBUG("Failed to queue response frame", status);
+    }
+    return true;
+}
 
-        /* data extracted from frame buffer is available to be deframed */
-        if (cbuf_size(&kiss_frame_cbuf) > 0) {
-            packet_complete = kiss_frame_unpack(&kiss_frame_cbuf, &packet_size, packet_buffer);
+/* Transmit the oldest pending responses, until an output frame isn't free */
+static void packet_flush(packet_ao_t *const self)
+{
+    while (self->pending_count > 0U) {
+        if (!packet_transmit(&self->pending[self->pending_head])) {
+            break;
         }
+        self->pending_head = (self->pending_head + 1U) % RESPONSE_COUNT;
+        self->pending_count--;
+    }
+}
 
-        /* No spacepackets available to process */
-        if ((packet_size <= 0) || (!packet_complete)) {
-            /* frame not finished, save buffer state, delay (to context switch to other task)
-             * and continue */
-            rtos_delay(2);
-            continue;
-        }
+static void packet_process(
+    packet_ao_t *const self,
+    size_t const packet_size,
+    uint8_t const packet_buffer[packet_size])
+{
 #if 0
-        debug_hex("recv packet", packet_size, packet_buffer);
+    debug_hex("recv packet", packet_size, packet_buffer);
 #endif
 
-        /* parse buffer as a spacepacket */
-        size_t response_size = 0;
-        uint8_t response_buffer[SPACEPACKET_HDR_SIZE + SPACEPACKET_DATA_MAX_SIZE] = {0};
-        /* Process buffer */
-        status = spacepacket_process(packet_size, packet_buffer, &response_size, response_buffer);
-        if (status == STATUS_OK) {
-            size_t output_frame_size = 0;
-            uint8_t output_frame_buffer[(SPACEPACKET_HDR_SIZE + SPACEPACKET_DATA_MAX_SIZE) * 2] = {
-                0};
-            kiss_frame_pack(
-                response_size,
-                response_buffer,
-                &output_frame_size,
-                output_frame_buffer);
-            uart_write_buf(UART1, output_frame_size, output_frame_buffer);
-        } else {
-            DEBUG("Failed to process spacepacket", status);
+    /* parse buffer as a spacepacket, dropped if too many responses are waiting to be sent */
+    response_t response = {.buf = pool_block_alloc(&response_pool), .size = 0};
+    if (response.buf == NULL) {
+        DEBUG("Failed to allocate response buffer", POOL_STATUS_EMPTY);
+        return;
+    }
+    /* Process buffer */
+    status_t const status =
+        spacepacket_process(packet_size, packet_buffer, &response.size, response.buf);
+    if (status != STATUS_OK) {
+        pool_free(response.buf);
+        DEBUG("Failed to process spacepacket", status);
+        return;
+    }
+
+    /* Hold the response, behind any already waiting, rather than wait for an output frame. Every
+     * held response has its own block, so there is always room */
+    if ((self->pending_count == 0U) && packet_transmit(&response)) {
+        return;
+    }
+    DBC_ASSERT(self->pending_count < RESPONSE_COUNT);
+    self->pending[(self->pending_head + self->pending_count) % RESPONSE_COUNT] = response;
+    self->pending_count++;
+}
+
+/* Deframe directly from the received frame, it may hold several packets or the end of a packet
+ * started in a previous frame. The frame is freed once handled */
+static void packet_deframe(packet_ao_t *const self, frame_t const *const frame)
+{
+    size_t consumed = 0;
+    while (consumed < frame->size) {
+        if (!kiss_frame_unpack_buf(
+                frame->size,
+                frame->data,
+                &consumed,
+                &self->packet_size,
+                self->packet_buffer,
+                &self->packet_esc)) {
+            break;
         }
+        packet_process(self, self->packet_size, self->packet_buffer);
         /* Clear packet buffer once processed */
-        packet_size = 0;
+        self->packet_size = 0;
+        self->packet_esc = false;
     }
 }
 
-void uart_handler(void)
+/**
+ * States
+ * - active: deframes and processes received packets
+ *   - idle: responses are transmitted as soon as they are built
+ *   - transmitting: every output frame is queued, responses are held until a tx done frees one
+ */
+static rtos_state_t packet_idle(rtos_hsm_t *const me, rtos_event_t const *const e);
+static rtos_state_t packet_transmitting(rtos_hsm_t *const me, rtos_event_t const *const e);
+
+static rtos_state_t packet_active(rtos_hsm_t *const me, rtos_event_t const *const e)
 {
-    uint8_t buf[CBUF_SIZE] = {0};
-    cbuf_t *const cbuf = uart_cbuf_get(UART1);
+    packet_ao_t *const self = (packet_ao_t *)me;
 
-    for (;;) {
-        size_t size = cbuf_size(cbuf);
-        if (size > 0) {
-            disable_irq();
-            status_t status = cbuf_read(cbuf, size, &buf[0]);
-            enable_irq();
-            if (status != STATUS_OK) {
-                DEBUG("Failed to read from uart buffer", status);
-                continue;
+    switch (e->sig) {
+        case FRAME_SIG: {
+            packet_deframe(self, (frame_t const *)e);
+            return RTOS_HANDLED();
+        }
+        case TX_DONE_SIG: {
+            /* Nothing is waiting for the output frame */
+            return RTOS_HANDLED();
+        }
+        default: {
+            return RTOS_SUPER(&rtos_hsm_top);
+        }
+    }
+}
+
+static rtos_state_t packet_idle(rtos_hsm_t *const me, rtos_event_t const *const e)
+{
+    packet_ao_t *const self = (packet_ao_t *)me;
+
+    switch (e->sig) {
+        case FRAME_SIG: {
+            packet_deframe(self, (frame_t const *)e);
+            if (self->pending_count > 0U) {
+                return RTOS_TRAN(&packet_transmitting);
             }
-            status = frame_buffer_write(size, buf);
-            if (status != STATUS_OK) {
-                DEBUG("Failed to write to frame buffer", status);
+            return RTOS_HANDLED();
+        }
+        default: {
+            return RTOS_SUPER(&packet_active);
+        }
+    }
+}
+
+static rtos_state_t packet_transmitting(rtos_hsm_t *const me, rtos_event_t const *const e)
+{
+    packet_ao_t *const self = (packet_ao_t *)me;
+
+    switch (e->sig) {
+        case TX_DONE_SIG: {
+            packet_flush(self);
+            if (self->pending_count == 0U) {
+                return RTOS_TRAN(&packet_idle);
             }
+            return RTOS_HANDLED();
+        }
+        default: {
+            return RTOS_SUPER(&packet_active);
+        }
+    }
+}
+
+static rtos_state_t packet_initial(rtos_hsm_t *const me, rtos_event_t const *const e)
+{
+    (void)e;
+    ((packet_ao_t *)me)->packet_size = 0;
+    ((packet_ao_t *)me)->packet_esc = false;
+    ((packet_ao_t *)me)->pending_head = 0U;
+    ((packet_ao_t *)me)->pending_count = 0U;
+    return RTOS_TRAN(&packet_idle);
+}
+
+/* Submitted by the uart isr when data is received, data arriving while this runs submits it
+ * again */
+static void uart_rx_work_handler(void *const arg)
+{
+    spsc_t *const rx = arg;
+
+    size_t size = spsc_count(rx);
+    while (size > 0) {
+        /* Waiting for the packet thread (lower priority) to free a frame would hold up the rest
+         * of the work queue. Leave the data in the ring instead, this is resubmitted when a frame
+         * is freed (frame_buffer_notify) */
+        frame_t *frame = NULL;
+        status_t status = frame_buffer_alloc(&frame, 0U);
+        if (status != STATUS_OK) {
+            break;
+        }
+
+        /* No critical section, the isr (in the zero-latency band, so it can't be masked by
+         * one) is the ring's only producer and this is its only consumer. If the dma has lapped
+         * the ring the read fails and the ring is resynced, the packet parser drops the partial
+         * frame on its checksum */
+        frame->size = (size < FRAME_BUFFER_SIZE) ? size : FRAME_BUFFER_SIZE;
+        status = spsc_read(rx, frame->size, frame->data);
+        if (status != STATUS_OK) {
+            DEBUG("Failed to read from uart buffer", status);
+            frame_buffer_free(frame);
+            break;
+        }
+        size -= frame->size;
+
+        /* Hand the frame over to the packet active object, it is freed if the queue is full */
+        status = frame_buffer_write(frame);
+        if (status != STATUS_OK) {
+            DEBUG("Failed to write to frame buffer", status);
         }
-        rtos_delay(1);
     }
 }
 
@@ -223,6 +403,35 @@ static status_t print_u32_param(void)
     return STATUS_OK;
 }
 
+/* Per-thread (and per-object) telemetry */
+#define THREAD_TLM(name, handler, thread)                                                          \
+    static status_t name(size_t *const size, uint8_t *const output)                                \
+    {                                                                                              \
+        return handler((thread), size, output);                                                    \
+    }
+
+THREAD_TLM(timer_thread_load, housekeeping_thread_load, rtos_timer_service_thread())
+THREAD_TLM(work_thread_load, housekeeping_thread_load, rtos_work_service_thread())
+THREAD_TLM(packet_thread_load, housekeeping_thread_load, PACKET_THREAD)
+THREAD_TLM(idle_thread_stack_used, housekeeping_thread_stack_used, rtos_thread_idle())
+THREAD_TLM(timer_thread_stack_used, housekeeping_thread_stack_used, rtos_timer_service_thread())
+THREAD_TLM(work_thread_stack_used, housekeeping_thread_stack_used, rtos_work_service_thread())
+THREAD_TLM(packet_thread_stack_used, housekeeping_thread_stack_used, PACKET_THREAD)
+THREAD_TLM(packet_thread_response_min, housekeeping_thread_response_min, PACKET_THREAD)
+THREAD_TLM(packet_thread_response_max, housekeeping_thread_response_max, PACKET_THREAD)
+THREAD_TLM(packet_thread_deadline_misses, housekeeping_thread_deadline_misses, PACKET_THREAD)
+THREAD_TLM(packet_thread_response_histogram, housekeeping_thread_response_histogram, PACKET_THREAD)
+THREAD_TLM(blinky_thread_load, housekeeping_thread_load, &blinky_thread)
+THREAD_TLM(blinky_thread_stack_used, housekeeping_thread_stack_used, &blinky_thread)
+THREAD_TLM(blinky_thread_jitter, housekeeping_thread_jitter, &blinky_thread)
+THREAD_TLM(blinky_thread_overruns, housekeeping_thread_overruns, &blinky_thread)
+THREAD_TLM(zig_timer_jitter, housekeeping_timer_jitter, &zig_timer)
+THREAD_TLM(zig_timer_overruns, housekeeping_timer_overruns, &zig_timer)
+THREAD_TLM(packet_queue_max, housekeeping_active_queue_max, &packet_ao.super)
+THREAD_TLM(frame_pool_usage, housekeeping_pool_usage, frame_buffer_pool())
+THREAD_TLM(response_pool_usage, housekeeping_pool_usage, &response_pool)
+THREAD_TLM(output_frame_pool_usage, housekeeping_pool_usage, &output_frame_pool)
+
 static action_handler_t action_table[] = {
     print_hello,
     print_u8_param,
@@ -234,14 +443,50 @@ static parameter_handler_t param_table[] = {
     {.set = set_u32_param, .get = get_u32_param},
 };
 
+/* Ids are positional and fixed once released, new telemetry is appended and removed telemetry
+ * is replaced by telemetry_retired */
 static telemetry_handler_t tlm_table[] = {
     spacepacket_out_of_seq_count,
     spacepacket_csum_error_count,
     spacepacket_last_seq_count,
-    frame_buffer_read_error_count,
+    telemetry_retired, /* frame_buffer_read_error_count */
     frame_buffer_write_error_count,
-    frame_buffer_read_last_status,
+    telemetry_retired, /* frame_buffer_read_last_status */
     frame_buffer_write_last_status,
+    housekeeping_uart1_tx_pending,
+    housekeeping_uart2_tx_pending,
+    housekeeping_cpu_load,
+    blinky_thread_load,
+    telemetry_retired, /* uart_thread_load, uart rx runs on the work thread */
+    packet_thread_load,
+    telemetry_retired, /* zig_thread_load, zig runs on the timer thread */
+    idle_thread_stack_used,
+    blinky_thread_stack_used,
+    telemetry_retired, /* uart_thread_stack_used */
+    packet_thread_stack_used,
+    telemetry_retired, /* zig_thread_stack_used */
+    housekeeping_critical_max_cycles,
+    blinky_thread_jitter,
+    blinky_thread_overruns,
+    /* Were the zig thread's release jitter/overruns, now its timer's callback latency jitter and
+     * overruns as zig runs on the timer thread */
+    zig_timer_jitter,
+    zig_timer_overruns,
+    timer_thread_load,
+    timer_thread_stack_used,
+    packet_thread_response_min,
+    packet_thread_response_max,
+    packet_thread_deadline_misses,
+    packet_thread_response_histogram,
+    work_thread_load,
+    work_thread_stack_used,
+    frame_buffer_free_min,
+    packet_queue_max,
+    frame_pool_usage,
+    response_pool_usage,
+    output_frame_pool_usage,
+    housekeeping_uart1_rx_overruns,
+    frame_buffer_alloc_fail_count,
 };
 
 int main(void)
@@ -249,27 +494,43 @@ int main(void)
     rtos_init(idle_thread_stack, sizeof(idle_thread_stack));
     uart_init(UART1, 9600);
     debug_init(UART2, 9600);
-    cbuf_init(uart_cbuf_get(UART1));  // init uart1 cbuf
-    frame_buffer_init();              // init frame buffer
+    uart_rx_dma_enable(UART1);        // receive uart1 with dma
+    frame_buffer_init(&packet_ao.super, FRAME_SIG); // frames are posted to the packet ao
+    pool_init(&response_pool, response_storage, POOL_BLOCK_SIZE(RESPONSE_SIZE), RESPONSE_COUNT);
+    pool_register(&response_pool);
+    pool_init(
+        &output_frame_pool,
+        output_frame_storage,
+        POOL_BLOCK_SIZE(OUTPUT_FRAME_SIZE),
+        OUTPUT_FRAME_COUNT);
+    pool_register(&output_frame_pool);
     debug_str("boot");
 
-    rtos_thread_create(&blinky_thread, &blinky_handler, blinky_stack, sizeof(blinky_stack), BLINKY_THREAD_PRIORITY);
-    rtos_thread_create(&uart_thread, &uart_handler, uart_stack, sizeof(uart_stack), UART_THREAD_PRIORITY);
-    rtos_thread_create(
-        &packet_thread,
-        &packet_thread_handler,
+    rtos_timer_service_init(TIMER_THREAD_PRIORITY);
+    rtos_work_service_init(WORK_THREAD_PRIORITY);
+    rtos_active_ctor(&packet_ao.super, &packet_initial);
+    rtos_active_start(
+        &packet_ao.super,
+        PACKET_THREAD_PRIORITY,
+        packet_queue,
+        PACKET_QUEUE_LEN,
         packet_thread_stack,
-        sizeof(packet_thread_stack),
-        PACKET_THREAD_PRIORITY);
-    rtos_thread_create(
-        &zig_thread,
-        &zig_main,
-        zig_thread_stack,
-        sizeof(zig_thread_stack),
-        ZIG_THREAD_PRIORITY);
+        sizeof(packet_thread_stack));
+    rtos_thread_set_deadline(PACKET_THREAD, PACKET_THREAD_DEADLINE);
+    rtos_work_init(&uart_rx_work, uart_rx_work_handler, uart_rx_get(UART1));
+    uart_rx_notify(UART1, &uart_rx_work);
+    frame_buffer_notify(&uart_rx_work);
 
     debug_str("threads created");
 
+    rtos_thread_create(
+        &blinky_thread,
+        &blinky_handler,
+        blinky_thread_stack,
+        sizeof(blinky_thread_stack),
+        BLINKY_THREAD_PRIORITY);
+    zig_main();
+
     /* Register actions/parameters/tlms */
     for (uint8_t i = 0; i < ARRAY_LEN(action_table); ++i) {
         action_register(i, action_table[i]);
@@ -0,0 +1,88 @@
+#include "rtos/active.h"
+
+#include "rtos/critical.h"
+#include "rtos/event.h"
+#include "rtos/hsm.h"
+#include "rtos/queue.h"
+#include "rtos/thread.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Thread handlers don't take an argument, the active object is found from its thread */
+static void rtos_active_thread_handler(void)
+{
+    rtos_active_t *const me =
+        (rtos_active_t *)((uint8_t *)rtos_thread_self() - offsetof(rtos_active_t, thread));
+
+    rtos_hsm_init(&me->hsm, NULL);
+
+    for (;;) {
+        rtos_event_t const *e = NULL;
+        DBC_ALLEGE(rtos_queue_receive(&me->queue, &e, RTOS_WAIT_FOREVER));
+
+        /* Each event is an activation for deadline monitoring, released when the thread was
+         * woken to receive it or, if it was already queued, when the last event was done */
+        rtos_thread_activation_start();
+        rtos_hsm_dispatch(&me->hsm, e);
+        rtos_event_gc(e);
+        rtos_thread_activation_end();
+    }
+}
+
+void rtos_active_ctor(rtos_active_t *const me, rtos_state_handler_t const initial)
+{
+    DBC_REQUIRE(me != NULL);
+
+    rtos_hsm_ctor(&me->hsm, initial);
+    me->queue_max = 0U;
+}
+
+void rtos_active_start(
+    rtos_active_t *const me,
+    uint8_t const priority,
+    rtos_event_t const **const queue_storage,
+    uint32_t const queue_len,
+    void *const stack,
+    uint32_t const stack_size)
+{
+    DBC_REQUIRE(me != NULL);
+
+    rtos_queue_init(&me->queue, queue_storage, sizeof(rtos_event_t const *), queue_len);
+    rtos_thread_create(&me->thread, &rtos_active_thread_handler, stack, stack_size, priority);
+}
+
+bool rtos_active_post(rtos_active_t *const me, rtos_event_t const *const e)
+{
+    DBC_REQUIRE(me != NULL);
+    DBC_REQUIRE(e != NULL);
+
+    /* Count the queue's reference before it can be received */
+    if (e->pool != NULL) {
+        uint32_t const basepri = rtos_critical_enter();
+        ((rtos_event_t *)e)->refs++;
+        rtos_critical_exit(basepri);
+    }
+
+    if (!rtos_queue_send(&me->queue, &e, 0U)) {
+        rtos_event_gc(e);
+        return false;
+    }
+
+    uint32_t const basepri = rtos_critical_enter();
+    uint32_t const count = rtos_queue_count(&me->queue);
+    if (count > me->queue_max) {
+        me->queue_max = count;
+    }
+    rtos_critical_exit(basepri);
+    return true;
+}
+
+uint32_t rtos_active_queue_max(rtos_active_t const *const me)
+{
+    DBC_REQUIRE(me != NULL);
+
+    return me->queue_max;
+}
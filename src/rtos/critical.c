@@ -0,0 +1,40 @@
+#include "rtos/critical.h"
+
+#include "hal/stm32f4_blackpill.h"
+
+#include <stdint.h>
+
+/* Critical section timing, measured with the DWT cycle counter (enabled by rtos_init) */
+static uint32_t rtos_critical_start = 0U;
+static uint32_t rtos_critical_max = 0U;
+
+uint32_t rtos_critical_enter(void)
+{
+    uint32_t const basepri = __get_BASEPRI();
+
+    /* Raising BASEPRI may not take effect for the next instruction on r0p1 Cortex-M4 cores
+     * (erratum 837070), so briefly mask all interrupts around it. BASEPRI_MAX never lowers an
+     * existing mask */
+    uint32_t const primask = __get_PRIMASK();
+    disable_irq();
+    __set_BASEPRI_MAX(RTOS_KERNEL_BASEPRI);
+    __set_PRIMASK(primask);
+
+    if (basepri == 0U) {
+        rtos_critical_start = DWT->CYCCNT;
+    }
+    return basepri;
+}
+
+void rtos_critical_exit(uint32_t const basepri)
+{
+    if (basepri == 0U) {
+        uint32_t const cycles = DWT->CYCCNT - rtos_critical_start;
+        if (cycles > rtos_critical_max) {
+            rtos_critical_max = cycles;
+        }
+    }
+    __set_BASEPRI(basepri);
+}
+
+uint32_t rtos_critical_max_cycles(void) { return rtos_critical_max; }
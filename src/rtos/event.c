@@ -0,0 +1,96 @@
+#include "rtos/event.h"
+
+#include "rtos/critical.h"
+#include "rtos/thread.h"
+#include "rtos/work.h"
+#include "utils/dbc_assert.h"
+#include "utils/pool.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+void rtos_event_pool_init(
+    rtos_event_pool_t *const self,
+    void *const storage,
+    size_t const block_size,
+    uint32_t const count)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(block_size >= sizeof(rtos_event_t));
+
+    pool_init(&self->blocks, storage, block_size, count);
+    rtos_sem_init(&self->free, count);
+    self->notify = NULL;
+}
+
+void rtos_event_pool_notify(rtos_event_pool_t *const self, rtos_work_t *const work)
+{
+    DBC_REQUIRE(self != NULL);
+
+    self->notify = work;
+}
+
+uint32_t rtos_event_pool_min_free(rtos_event_pool_t const *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    return self->blocks.count - self->blocks.used_max;
+}
+
+pool_t const *rtos_event_pool_blocks(rtos_event_pool_t const *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    return &self->blocks;
+}
+
+rtos_event_t *rtos_event_new(
+    rtos_event_pool_t *const pool,
+    uint16_t const sig,
+    uint32_t const ticks)
+{
+    DBC_REQUIRE(pool != NULL);
+    DBC_REQUIRE(sig >= RTOS_USER_SIG);
+
+    if (!rtos_sem_take_timeout(&pool->free, ticks)) {
+        return NULL;
+    }
+
+    /* Taking the semaphore reserved a block, so the pool can't be empty */
+    rtos_event_t *const event = pool_block_alloc(&pool->blocks);
+    DBC_ASSERT(event != NULL);
+
+    event->sig = sig;
+    event->refs = 0U;
+    event->pool = pool;
+    return event;
+}
+
+void rtos_event_gc(rtos_event_t const *const event)
+{
+    DBC_REQUIRE(event != NULL);
+
+    /* Static events are never freed */
+    if (event->pool == NULL) {
+        return;
+    }
+
+    /* The only mutable part of an event is its reference count, owned by the framework */
+    rtos_event_t *const e = (rtos_event_t *)event;
+
+    uint32_t const basepri = rtos_critical_enter();
+    bool const last = (e->refs <= 1U);
+    if (!last) {
+        e->refs--;
+    }
+    rtos_critical_exit(basepri);
+
+    if (last) {
+        pool_block_free(&e->pool->blocks, e);
+        rtos_sem_give(&e->pool->free);
+        if (e->pool->notify != NULL) {
+            (void)rtos_work_submit(e->pool->notify);
+        }
+    }
+}
@@ -0,0 +1,241 @@
+#include "rtos/hsm.h"
+
+#include "rtos/event.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Events of the reserved signals, sent to states by the dispatcher */
+static rtos_event_t const rtos_hsm_reserved[RTOS_USER_SIG] = {
+    [RTOS_EMPTY_SIG] = {.sig = RTOS_EMPTY_SIG, .refs = 0U, .pool = NULL},
+    [RTOS_ENTRY_SIG] = {.sig = RTOS_ENTRY_SIG, .refs = 0U, .pool = NULL},
+    [RTOS_EXIT_SIG] = {.sig = RTOS_EXIT_SIG, .refs = 0U, .pool = NULL},
+    [RTOS_INIT_SIG] = {.sig = RTOS_INIT_SIG, .refs = 0U, .pool = NULL},
+};
+
+/* Send a reserved signal to a state */
+static inline rtos_state_t rtos_hsm_trig(
+    rtos_hsm_t *const me,
+    rtos_state_handler_t const state,
+    uint16_t const sig)
+{
+    return state(me, &rtos_hsm_reserved[sig]);
+}
+
+/* Exit a state, leaving its superstate in me->temp */
+static void rtos_hsm_exit(rtos_hsm_t *const me, rtos_state_handler_t const state)
+{
+    /* A state without an exit action returns its superstate straight away */
+    if (rtos_hsm_trig(me, state, RTOS_EXIT_SIG) == RTOS_RET_HANDLED) {
+        (void)rtos_hsm_trig(me, state, RTOS_EMPTY_SIG);
+    }
+}
+
+/* Enter path[ip] down to path[0] */
+static void rtos_hsm_enter(rtos_hsm_t *const me, rtos_state_handler_t const path[], int8_t ip)
+{
+    for (; ip >= 0; --ip) {
+        (void)rtos_hsm_trig(me, path[ip], RTOS_ENTRY_SIG);
+    }
+}
+
+/* Take the initial transitions nested in state, returning the leaf state */
+static rtos_state_handler_t rtos_hsm_drill(rtos_hsm_t *const me, rtos_state_handler_t state)
+{
+    rtos_state_handler_t path[RTOS_HSM_MAX_DEPTH];
+
+    while (rtos_hsm_trig(me, state, RTOS_INIT_SIG) == RTOS_RET_TRAN) {
+        /* Walk up from the target to the state, then enter back down to the target */
+        int8_t ip = 0;
+        path[0] = me->temp;
+        (void)rtos_hsm_trig(me, me->temp, RTOS_EMPTY_SIG);
+        while (me->temp != state) {
+            ++ip;
+            DBC_ASSERT(ip < RTOS_HSM_MAX_DEPTH);
+            path[ip] = me->temp;
+            (void)rtos_hsm_trig(me, me->temp, RTOS_EMPTY_SIG);
+        }
+        rtos_hsm_enter(me, path, ip);
+        state = path[0];
+    }
+    return state;
+}
+
+/* Exit up from the source and enter down to the target (path[0]) of a transition through their
+ * least common ancestor. path[2] holds the source, the source has been exited down to already.
+ * Returns the index in path of the outermost state to enter, -1 if none */
+static int8_t rtos_hsm_tran(rtos_hsm_t *const me, rtos_state_handler_t path[RTOS_HSM_MAX_DEPTH])
+{
+    int8_t ip = -1;
+    rtos_state_handler_t const source = path[2];
+    rtos_state_handler_t t = path[0];
+
+    /* (a) transition to self */
+    if (source == t) {
+        (void)rtos_hsm_trig(me, source, RTOS_EXIT_SIG);
+        return 0;
+    }
+
+    (void)rtos_hsm_trig(me, t, RTOS_EMPTY_SIG);
+    t = me->temp; /* superstate of the target */
+
+    /* (b) source is the target's superstate */
+    if (source == t) {
+        return 0;
+    }
+
+    (void)rtos_hsm_trig(me, source, RTOS_EMPTY_SIG);
+
+    /* (c) source and target share a superstate */
+    if (me->temp == t) {
+        (void)rtos_hsm_trig(me, source, RTOS_EXIT_SIG);
+        return 0;
+    }
+
+    /* (d) target is the source's superstate */
+    if (me->temp == path[0]) {
+        (void)rtos_hsm_trig(me, source, RTOS_EXIT_SIG);
+        return -1;
+    }
+
+    /* (e) source is further up the target's ancestors, record them in path on the way */
+    bool found = false;
+    ip = 1;
+    path[1] = t;
+    t = me->temp; /* superstate of the source */
+    rtos_state_t r = rtos_hsm_trig(me, path[1], RTOS_EMPTY_SIG);
+    while (r == RTOS_RET_SUPER) {
+        ++ip;
+        DBC_ASSERT(ip < RTOS_HSM_MAX_DEPTH);
+        path[ip] = me->temp;
+        if (me->temp == source) {
+            found = true;
+            --ip; /* don't enter the source */
+            r = RTOS_RET_HANDLED;
+        } else {
+            r = rtos_hsm_trig(me, me->temp, RTOS_EMPTY_SIG);
+        }
+    }
+    if (found) {
+        return ip;
+    }
+
+    (void)rtos_hsm_trig(me, source, RTOS_EXIT_SIG);
+
+    /* (f) source's superstate is one of the target's ancestors */
+    for (int8_t iq = ip; iq >= 0; --iq) {
+        if (t == path[iq]) {
+            return (int8_t)(iq - 1);
+        }
+    }
+
+    /* (g) exit up the source's ancestors until one of the target's ancestors is reached, the top
+     * state is always common */
+    for (;;) {
+        rtos_hsm_exit(me, t);
+        t = me->temp;
+        for (int8_t iq = ip; iq >= 0; --iq) {
+            if (t == path[iq]) {
+                return (int8_t)(iq - 1);
+            }
+        }
+    }
+}
+
+rtos_state_t rtos_hsm_top(rtos_hsm_t *const me, rtos_event_t const *const e)
+{
+    (void)me;
+    (void)e;
+    return RTOS_IGNORED();
+}
+
+void rtos_hsm_ctor(rtos_hsm_t *const me, rtos_state_handler_t const initial)
+{
+    DBC_REQUIRE(me != NULL);
+    DBC_REQUIRE(initial != NULL);
+
+    me->state = &rtos_hsm_top;
+    me->temp = initial;
+}
+
+void rtos_hsm_init(rtos_hsm_t *const me, rtos_event_t const *const e)
+{
+    DBC_REQUIRE(me != NULL);
+    DBC_REQUIRE(me->state == &rtos_hsm_top);
+
+    /* The initial transition must target a state */
+    DBC_ALLEGE((*me->temp)(me, e) == RTOS_RET_TRAN);
+
+    /* Enter the target down from the top state, then its nested initial transitions */
+    rtos_state_handler_t path[RTOS_HSM_MAX_DEPTH];
+    int8_t ip = 0;
+    path[0] = me->temp;
+    (void)rtos_hsm_trig(me, me->temp, RTOS_EMPTY_SIG);
+    while (me->temp != &rtos_hsm_top) {
+        ++ip;
+        DBC_ASSERT(ip < RTOS_HSM_MAX_DEPTH);
+        path[ip] = me->temp;
+        (void)rtos_hsm_trig(me, me->temp, RTOS_EMPTY_SIG);
+    }
+    rtos_hsm_enter(me, path, ip);
+
+    rtos_state_handler_t const state = rtos_hsm_drill(me, path[0]);
+    me->state = state;
+    me->temp = state;
+}
+
+void rtos_hsm_dispatch(rtos_hsm_t *const me, rtos_event_t const *const e)
+{
+    DBC_REQUIRE(me != NULL);
+    DBC_REQUIRE(e != NULL);
+    DBC_REQUIRE(me->temp == me->state);
+
+    /* Offer the event to the current state and up through its superstates */
+    rtos_state_handler_t t = me->state;
+    rtos_state_handler_t s = NULL;
+    rtos_state_t r = RTOS_RET_SUPER;
+    do {
+        s = me->temp;
+        r = (*s)(me, e);
+    } while (r == RTOS_RET_SUPER);
+
+    if (r == RTOS_RET_TRAN) {
+        rtos_state_handler_t path[RTOS_HSM_MAX_DEPTH];
+        path[0] = me->temp; /* target */
+        path[1] = t;        /* current state */
+        path[2] = s;        /* source, the state that handled the event */
+
+        /* Exit from the current state up to the source */
+        for (; t != s; t = me->temp) {
+            rtos_hsm_exit(me, t);
+        }
+
+        rtos_hsm_enter(me, path, rtos_hsm_tran(me, path));
+        t = rtos_hsm_drill(me, path[0]);
+    }
+
+    me->state = t;
+    me->temp = t;
+}
+
+bool rtos_hsm_is_in(rtos_hsm_t *const me, rtos_state_handler_t const state)
+{
+    DBC_REQUIRE(me != NULL);
+    DBC_REQUIRE(me->temp == me->state);
+
+    bool in = false;
+    rtos_state_t r = RTOS_RET_SUPER;
+    while ((r == RTOS_RET_SUPER) && !in) {
+        if (me->temp == state) {
+            in = true;
+        } else {
+            r = rtos_hsm_trig(me, me->temp, RTOS_EMPTY_SIG);
+        }
+    }
+
+    /* Restore the invariant */
+    me->temp = me->state;
+    return in;
+}
@@ -0,0 +1,75 @@
+#include "rtos/queue.h"
+
+#include "rtos/critical.h"
+#include "rtos/thread.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+void rtos_queue_init(
+    rtos_queue_t *const self,
+    void *const storage,
+    size_t const item_size,
+    uint32_t const capacity)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(storage != NULL);
+    DBC_REQUIRE(item_size > 0U);
+    DBC_REQUIRE(capacity > 0U);
+
+    self->storage = storage;
+    self->item_size = item_size;
+    self->capacity = capacity;
+    self->head = 0U;
+    self->tail = 0U;
+    rtos_sem_init(&self->items, 0U);
+    rtos_sem_init(&self->slots, capacity);
+}
+
+bool rtos_queue_send(rtos_queue_t *const self, void const *const item, uint32_t const ticks)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(item != NULL);
+
+    /* Reserve a slot, the slot count guarantees the tail slot is free */
+    if (!rtos_sem_take_timeout(&self->slots, ticks)) {
+        return false;
+    }
+
+    /* Save the previous mask, as senders may be isrs */
+    uint32_t const basepri = rtos_critical_enter();
+    memcpy(&self->storage[self->tail * self->item_size], item, self->item_size);
+    self->tail = (self->tail + 1U) % self->capacity;
+    rtos_critical_exit(basepri);
+
+    rtos_sem_give(&self->items);
+    return true;
+}
+
+bool rtos_queue_receive(rtos_queue_t *const self, void *const item, uint32_t const ticks)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(item != NULL);
+
+    if (!rtos_sem_take_timeout(&self->items, ticks)) {
+        return false;
+    }
+
+    uint32_t const basepri = rtos_critical_enter();
+    memcpy(item, &self->storage[self->head * self->item_size], self->item_size);
+    self->head = (self->head + 1U) % self->capacity;
+    rtos_critical_exit(basepri);
+
+    rtos_sem_give(&self->slots);
+    return true;
+}
+
+uint32_t rtos_queue_count(rtos_queue_t const *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    return self->items.count;
+}
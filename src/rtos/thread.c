@@ -2,6 +2,8 @@
 #include "rtos/thread.h"
 
 #include "hal/stm32f4_blackpill.h"
+#include "rtos/critical.h"
+#include "rtos/trace.h"
 #include "utils/dbc_assert.h"
 
 #include <stddef.h>
@@ -13,26 +15,210 @@
 
 #define RTOS_IDLE_THREAD_PRIORITY (0U)
 
+#define RTOS_STACK_PAINT (0xBABECAFEU)
+
+/* MPU region used for the running thread's stack guard */
+#define RTOS_STACK_GUARD_REGION (0U)
+/* MPU encoding of RTOS_STACK_GUARD_SIZE */
+#define RTOS_STACK_GUARD_REGION_SIZE (ARM_MPU_REGION_SIZE_256B)
+
+/* Words of stack checked per pass of the idle thread by the stack scanner */
+#define RTOS_STACK_SCAN_WORDS (16U)
+
 #ifndef __ARM_FEATURE_CLZ
 #error "CLZ instruction not supported!"
 #endif
 
-/* Use Log2 to identify the index of the highest priority thread by counting the
- * leading zeros of the bitfield */
-#define LOG2(x) (32 - __builtin_clz((x)))
+/* Index of the highest set bit, found by counting the leading zeros of the bitfield */
+#define HIGHEST_BIT(x) (31U - (uint32_t)__builtin_clz((x)))
+
+/* Words in the second level of the ready bitmap, one bit per priority */
+#define RTOS_READY_WORDS ((RTOS_PRIORITY_COUNT + 31U) / 32U)
+
+#if (RTOS_PRIORITY_COUNT > 256U)
+#error "Priorities must fit in a uint8_t!"
+#endif
 
 /* Pointer to current/next thread for scheduling */
 rtos_thread_t *volatile rtos_current;
 rtos_thread_t *volatile rtos_next;
 
-rtos_thread_t *rtos_threads[32 + 1] = {NULL};
-uint32_t rtos_ready_set = 0;
-uint32_t rtos_delayed_set = 0;
+/* Ready threads, a circular list per priority whose head is the next to run. Round robin moves
+ * the head along the list when the running thread's time slice expires */
+static rtos_thread_t *rtos_ready[RTOS_PRIORITY_COUNT] = {NULL};
+
+/* Two level bitmap of the non-empty ready lists, so the highest priority is found with two
+ * CLZs however many levels there are. Bit n of rtos_ready_group is set if rtos_ready_set[n] is
+ * non-zero, and bit m of rtos_ready_set[n] if priority (32 * n) + m is ready */
+static uint32_t rtos_ready_group = 0U;
+static uint32_t rtos_ready_set[RTOS_READY_WORDS] = {0U};
+
+/* Every thread, in the order they were created */
+static rtos_thread_t *rtos_thread_list = NULL;
+
+/* Threads with a timeout, sorted by wake-up time. Each thread's timeout holds the ticks
+ * remaining after the thread before it expires (a delta list), so rtos_tick only decrements the
+ * head of the list and only touches the threads that expire */
+static rtos_thread_t *rtos_delayed = NULL;
+
+/* CPU load accounting, cycles are charged to the running thread on every context switch and
+ * latched into load_cycles at the end of each window */
+static uint32_t rtos_switch_cycles = 0;  /* CYCCNT at the last context switch */
+static uint32_t rtos_window_start = 0;   /* CYCCNT at the start of the current window */
+static uint32_t rtos_window_cycles = 0;  /* Length in cycles of the last complete window */
+static uint32_t rtos_window_ticks = 0;   /* Ticks elapsed in the current window */
+
+/* Ticks since the rtos started */
+static volatile uint32_t rtos_ticks = 0;
+static uint32_t rtos_tick_cycles = 0;        /* CYCCNT at the last tick */
+static uint32_t rtos_tick_period_cycles = 0; /* Cycles per tick, measured between ticks */
+
+/* Set by rtos_thread_signal from zero-latency isrs, which can't touch the scheduler state, for
+ * the signals to be delivered from PendSV */
+static volatile bool rtos_signal_deferred = false;
+
+/* Stack scanner position, the paint is checked upwards from the bottom of each thread's stack
+ * until the first overwritten word, a few words per pass of the idle thread */
+static rtos_thread_t *rtos_scan_thread = NULL;
+static uint32_t const *rtos_scan_cursor = NULL;
+
+static void rtos_stack_scan(void)
+{
+    rtos_thread_t *const thread = rtos_scan_thread;
+    if (thread != NULL) {
+        if (rtos_scan_cursor == NULL) {
+            rtos_scan_cursor = thread->stack_limit;
+        }
+
+        uint32_t words = RTOS_STACK_SCAN_WORDS;
+        while ((words-- > 0U) && (rtos_scan_cursor < thread->stack_top)) {
+            if (*rtos_scan_cursor != RTOS_STACK_PAINT) {
+                break;
+            }
+            ++rtos_scan_cursor;
+        }
+
+        bool const done = (rtos_scan_cursor >= thread->stack_top)
+            || (*rtos_scan_cursor != RTOS_STACK_PAINT);
+        if (!done) {
+            return;
+        }
+
+        uint32_t const used = (uint32_t)(thread->stack_top - rtos_scan_cursor) * sizeof(uint32_t);
+        if (used > thread->stack_used) {
+            thread->stack_used = used;
+        }
+    }
+
+    /* Move on to the next thread, threads are never removed so the list can be walked outside
+     * of a critical section */
+    rtos_scan_cursor = NULL;
+    rtos_scan_thread = (thread != NULL) ? thread->list_next : NULL;
+    if (rtos_scan_thread == NULL) {
+        rtos_scan_thread = rtos_thread_list;
+    }
+}
+
+/* Add a thread to the tail of its priority's ready list, if it isn't already ready (a thread
+ * that timed out can be signalled or given a semaphore before it runs). Requires a critical
+ * section */
+static void rtos_ready_insert(rtos_thread_t *const thread)
+{
+    if (thread->ready_next != NULL) {
+        return;
+    }
+    RTOS_TRACE(RTOS_TRACE_READY, thread, thread->priority);
+
+    /* The first wake-up between activations is the release of the next one, wake-ups within an
+     * activation (e.g. from waiting on a mutex) don't move it */
+    if (!thread->activation_started && !thread->activation_woken) {
+        thread->activation_woken = true;
+        thread->activation_cycles = DWT->CYCCNT;
+    }
+
+    uint8_t const priority = thread->priority;
+    rtos_thread_t *const head = rtos_ready[priority];
+    if (head == NULL) {
+        thread->ready_next = thread;
+        thread->ready_prev = thread;
+        rtos_ready[priority] = thread;
+        rtos_ready_set[priority / 32U] |= (1U << (priority % 32U));
+        rtos_ready_group |= (1U << (priority / 32U));
+    } else {
+        thread->ready_next = head;
+        thread->ready_prev = head->ready_prev;
+        head->ready_prev->ready_next = thread;
+        head->ready_prev = thread;
+    }
+}
+
+/* Remove a thread from its priority's ready list. Requires a critical section */
+static void rtos_ready_remove(rtos_thread_t *const thread)
+{
+    DBC_ASSERT(thread->ready_next != NULL);
+
+    uint8_t const priority = thread->priority;
+    if (thread->ready_next == thread) {
+        rtos_ready[priority] = NULL;
+        rtos_ready_set[priority / 32U] &= ~(1U << (priority % 32U));
+        if (rtos_ready_set[priority / 32U] == 0U) {
+            rtos_ready_group &= ~(1U << (priority / 32U));
+        }
+    } else {
+        thread->ready_prev->ready_next = thread->ready_next;
+        thread->ready_next->ready_prev = thread->ready_prev;
+        if (rtos_ready[priority] == thread) {
+            rtos_ready[priority] = thread->ready_next;
+        }
+    }
+
+    thread->ready_next = NULL;
+    thread->ready_prev = NULL;
+}
+
+/* Highest priority with a ready thread, the idle thread is always ready. Requires a critical
+ * section */
+static inline uint8_t rtos_ready_highest(void)
+{
+    DBC_ASSERT(rtos_ready_group != 0U);
+
+    uint32_t const word = HIGHEST_BIT(rtos_ready_group);
+    return (uint8_t)((word * 32U) + HIGHEST_BIT(rtos_ready_set[word]));
+}
+
+/* Park a thread in a waiting list, behind any waiters of the same or higher priority. Requires a
+ * critical section */
+static void rtos_wait_insert(rtos_thread_t **const list, rtos_thread_t *const thread)
+{
+    rtos_thread_t **link = list;
+    while ((*link != NULL) && ((*link)->priority >= thread->priority)) {
+        link = &(*link)->wait_next;
+    }
+
+    thread->wait_next = *link;
+    *link = thread;
+    thread->wait_list = list;
+}
+
+/* Remove a thread from the waiting list it is parked in. Requires a critical section */
+static void rtos_wait_remove(rtos_thread_t *const thread)
+{
+    rtos_thread_t **link = thread->wait_list;
+    while (*link != thread) {
+        DBC_ASSERT(*link != NULL);
+        link = &(*link)->wait_next;
+    }
+
+    *link = thread->wait_next;
+    thread->wait_next = NULL;
+    thread->wait_list = NULL;
+}
 
 rtos_thread_t idle_thread = {0};
 void idle_thread_handler()
 {
     for (;;) {
+        rtos_stack_scan();
         rtos_on_idle();
     }
 }
@@ -43,6 +229,21 @@ void rtos_init(void *const idle_thread_stack, uint32_t const idle_thread_stack_s
      * Equivilent of `NVIC_setPriority(PendSV_IRQn, 0xFFU)` */
     NVIC_SHPR3_REV |= (0xFFU << 16U);
 
+    /* Enable the MPU with the default memory map, the only region is the running thread's stack
+     * guard (set up on each context switch) */
+    DBC_ASSERT((2U << RTOS_STACK_GUARD_REGION_SIZE) == RTOS_STACK_GUARD_SIZE);
+    ARM_MPU_ClrRegion(RTOS_STACK_GUARD_REGION);
+    ARM_MPU_Enable(MPU_CTRL_PRIVDEFENA_Msk);
+
+    /* Keep automatic and lazy stacking of the fpu context (the reset default), so exceptions only
+     * save s0-s15 for threads that use the fpu, and only if the handler uses it too */
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+
+    /* Enable the DWT cycle counter for load accounting */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     /* create idle thread */
     rtos_thread_create(
         &idle_thread,
@@ -54,14 +255,10 @@ void rtos_init(void *const idle_thread_stack, uint32_t const idle_thread_stack_s
 
 void rtos_schedule(void)
 {
-    /* No threads are ready to run, so set to Idle thread */
-    if (rtos_ready_set == 0U) {
-        rtos_next = rtos_threads[0]; /* idle thread */
-    } else {
-        /* Find next thread to run */
-        rtos_next = rtos_threads[LOG2(rtos_ready_set)];
-        DBC_ASSERT(rtos_next != NULL);
-    }
+    /* Next thread to run is the head of the highest priority ready list, which is the idle
+     * thread if no other threads are ready */
+    rtos_next = rtos_ready[rtos_ready_highest()];
+    DBC_ASSERT(rtos_next != NULL);
 
     if (rtos_next != rtos_current) {
         /* raise pendsv irq by setting "set pending" bit of interrupt and control state register
@@ -73,46 +270,772 @@ void rtos_run(void)
 {
     rtos_on_startup();
 
-    disable_irq();
+    uint32_t const basepri = rtos_critical_enter();
     rtos_schedule();
-    enable_irq();
+    rtos_critical_exit(basepri);
 
     /* the following should never execute */
     DBC_ERROR();
 }
 
-void rtos_tick(void)
+/* Insert a thread into the delayed list to expire in ticks. Requires a critical section */
+static void rtos_delayed_insert(rtos_thread_t *const thread, uint32_t ticks)
+{
+    DBC_REQUIRE(ticks != 0U);
+
+    /* Walk past every thread expiring at or before the thread, so threads expiring on the same
+     * tick are woken in the order they were delayed */
+    rtos_thread_t *prev = NULL;
+    rtos_thread_t *next = rtos_delayed;
+    while ((next != NULL) && (next->timeout <= ticks)) {
+        ticks -= next->timeout;
+        prev = next;
+        next = next->delay_next;
+    }
+
+    thread->timeout = ticks;
+    thread->delay_prev = prev;
+    thread->delay_next = next;
+    if (next != NULL) {
+        next->timeout -= ticks;
+        next->delay_prev = thread;
+    }
+    if (prev != NULL) {
+        prev->delay_next = thread;
+    } else {
+        rtos_delayed = thread;
+    }
+}
+
+/* Remove a thread from the delayed list, if it is in it. Requires a critical section */
+static void rtos_delayed_remove(rtos_thread_t *const thread)
+{
+    if ((thread->delay_prev == NULL) && (rtos_delayed != thread)) {
+        return;
+    }
+
+    /* Hand the remaining delta over to the next thread so its wake-up time is unchanged */
+    rtos_thread_t *const next = thread->delay_next;
+    if (next != NULL) {
+        next->timeout += thread->timeout;
+        next->delay_prev = thread->delay_prev;
+    }
+    if (thread->delay_prev != NULL) {
+        thread->delay_prev->delay_next = next;
+    } else {
+        rtos_delayed = next;
+    }
+
+    thread->timeout = 0U;
+    thread->delay_prev = NULL;
+    thread->delay_next = NULL;
+}
+
+void rtos_tick(void) { rtos_tick_advance(1U); }
+
+/* Charge the cycles since the last switch to the running thread. Requires a critical section */
+static void rtos_thread_account(void)
+{
+    uint32_t const now = DWT->CYCCNT;
+    if (rtos_current != NULL) {
+        rtos_current->cycles += now - rtos_switch_cycles;
+    }
+    rtos_switch_cycles = now;
+}
+
+/* Whether the running isr is in the zero-latency band (above the kernel priority) */
+static inline bool rtos_isr_is_zero_latency(void)
 {
-    uint32_t working_set = rtos_delayed_set;
-    while (working_set != 0U) {
-        rtos_thread_t *thread = rtos_threads[LOG2(working_set)];
-        DBC_ASSERT(thread != NULL);
-        DBC_ASSERT(thread->timeout != 0U);
+    uint32_t const ipsr = __get_IPSR();
+    if (ipsr == 0U) {
+        return false;
+    }
+    /* NMI (2) and HardFault (3) have fixed negative priorities, above BASEPRI, and no entry in
+     * the priority registers NVIC_GetPriority reads */
+    if (ipsr < 4U) {
+        return true;
+    }
+    return NVIC_GetPriority((IRQn_Type)((int32_t)ipsr - 16)) < RTOS_KERNEL_IRQ_PRIORITY;
+}
 
-        uint32_t thread_bit = (1U << (thread->priority - 1U));
-        --thread->timeout;
-        if (thread->timeout == 0U) {
-            rtos_ready_set |= thread_bit;
-            rtos_delayed_set &= ~thread_bit;
+/* Deliver a signal to a thread. Requires a critical section */
+static void rtos_thread_signal_locked(rtos_thread_t *const thread)
+{
+    thread->signalled = true;
+    if (thread->waiting_signal) {
+        thread->waiting_signal = false;
+        rtos_delayed_remove(thread);
+        rtos_ready_insert(thread);
+        rtos_schedule();
+    }
+}
+
+/* Deliver the signals raised by zero-latency isrs. Requires a critical section */
+static void rtos_signal_deferred_deliver(void)
+{
+    rtos_signal_deferred = false;
+
+    for (rtos_thread_t *thread = rtos_thread_list; thread != NULL; thread = thread->list_next) {
+        if (thread->signal_deferred) {
+            thread->signal_deferred = false;
+            rtos_thread_signal_locked(thread);
         }
-        working_set &= ~thread_bit;
     }
 }
 
+void rtos_thread_switch_hook(void)
+{
+    if (rtos_signal_deferred) {
+        rtos_signal_deferred_deliver();
+    }
+
+    rtos_thread_account();
+
+    /* Start a fresh time slice for the thread being switched in */
+    if (rtos_next != rtos_current) {
+        RTOS_TRACE(RTOS_TRACE_SWITCH, rtos_current, rtos_next->id);
+        rtos_next->slice_remaining = rtos_next->time_slice;
+    }
+
+    /* Move the stack guard below the next thread's stack, any access to it (i.e. the stack
+     * overflowing) raises a MemManage fault. The exception return synchronises the change */
+    uint32_t const guard = (uint32_t)rtos_next->stack_limit - RTOS_STACK_GUARD_SIZE;
+    ARM_MPU_SetRegion(
+        ARM_MPU_RBAR(RTOS_STACK_GUARD_REGION, guard),
+        ARM_MPU_RASR(1U, ARM_MPU_AP_NONE, 0U, 0U, 0U, 0U, 0U, RTOS_STACK_GUARD_REGION_SIZE));
+}
+
+/* Latch the cycles each thread ran for in the window that has just ended. Requires a critical
+ * section */
+static void rtos_load_window_end(void)
+{
+    rtos_thread_account();
+
+    uint32_t const now = DWT->CYCCNT;
+    rtos_window_cycles = now - rtos_window_start;
+    rtos_window_start = now;
+
+    for (rtos_thread_t *thread = rtos_thread_list; thread != NULL; thread = thread->list_next) {
+        thread->load_cycles = thread->cycles;
+        thread->cycles = 0U;
+    }
+}
+
+void rtos_tick_advance(uint32_t ticks)
+{
+    /* Save the previous mask, as this may be called from within a critical section */
+    uint32_t const basepri = rtos_critical_enter();
+
+    /* The tick period is measured rather than configured. Only single ticks come from the tick
+     * interrupt, tickless idle advances (possibly by 0) part way through a tick */
+    uint32_t const now = DWT->CYCCNT;
+    if (ticks == 1U) {
+        rtos_tick_period_cycles = now - rtos_tick_cycles;
+    }
+    if (ticks > 0U) {
+        rtos_tick_cycles = now;
+    }
+
+    rtos_ticks += ticks;
+    rtos_window_ticks += ticks;
+    if (rtos_window_ticks >= RTOS_LOAD_WINDOW_TICKS) {
+        rtos_window_ticks = 0U;
+        rtos_load_window_end();
+    }
+
+    /* Round robin, once the running thread's slice has expired move it behind the other ready
+     * threads of its priority. It is only at the head of its ready list if it hasn't blocked */
+    rtos_thread_t *const current = rtos_current;
+    if ((current != NULL) && (current->time_slice != 0U)
+        && (rtos_ready[current->priority] == current) && (current->ready_next != current)) {
+        if (current->slice_remaining > ticks) {
+            current->slice_remaining -= ticks;
+        } else {
+            current->slice_remaining = current->time_slice;
+            rtos_ready[current->priority] = current->ready_next;
+        }
+    }
+
+    while ((ticks > 0U) && (rtos_delayed != NULL)) {
+        DBC_ASSERT(rtos_delayed->timeout != 0U);
+        if (rtos_delayed->timeout > ticks) {
+            rtos_delayed->timeout -= ticks;
+            break;
+        }
+        ticks -= rtos_delayed->timeout;
+        rtos_delayed->timeout = 0U;
+
+        /* Wake every thread at the head of the list that has expired */
+        while ((rtos_delayed != NULL) && (rtos_delayed->timeout == 0U)) {
+            rtos_thread_t *const thread = rtos_delayed;
+            rtos_delayed = thread->delay_next;
+            if (rtos_delayed != NULL) {
+                rtos_delayed->delay_prev = NULL;
+            }
+            thread->delay_next = NULL;
+            thread->release_cycles = DWT->CYCCNT;
+
+            /* Still parked in a waiting list if it timed out blocking on a semaphore, the
+             * waiter removes itself once it runs */
+            rtos_ready_insert(thread);
+        }
+    }
+
+    rtos_critical_exit(basepri);
+}
+
+uint32_t rtos_idle_ticks(void)
+{
+    if (rtos_ready_highest() != RTOS_IDLE_THREAD_PRIORITY) {
+        return 0U;
+    }
+    if (rtos_delayed == NULL) {
+        return RTOS_WAIT_FOREVER;
+    }
+    return rtos_delayed->timeout;
+}
+
+/* Start a thread's activation. It was released when the thread was woken since the previous
+ * activation ended, or when that ended if the thread didn't need to block. Requires a critical
+ * section */
+static void rtos_thread_activation_start_locked(rtos_thread_t *const thread)
+{
+    thread->activation_started = true;
+}
+
+/* Record the response time of a thread's activation, the end is the release of the next one
+ * unless the thread is woken before it starts. Requires a critical section */
+static void rtos_thread_activation_end_locked(rtos_thread_t *const thread)
+{
+    if (!thread->activation_started) {
+        return;
+    }
+
+    uint32_t const now = DWT->CYCCNT;
+    uint32_t const response = now - thread->activation_cycles;
+    thread->activation_cycles = now;
+    thread->activation_started = false;
+    thread->activation_woken = false;
+
+    uint32_t const deadline = thread->deadline;
+    if (deadline == 0U) {
+        return;
+    }
+
+    if (response < thread->response_min) {
+        thread->response_min = response;
+    }
+    if (response > thread->response_max) {
+        thread->response_max = response;
+    }
+    if (response > deadline) {
+        thread->deadline_misses++;
+        RTOS_TRACE(
+            RTOS_TRACE_DEADLINE_MISS,
+            thread,
+            ((uint64_t)response * 100U) / deadline);
+    }
+
+    /* Buckets are closed at the top, so a response on the deadline is counted as meeting it */
+    uint32_t bucket = (response == 0U)
+        ? 0U
+        : (uint32_t)(((uint64_t)(response - 1U) * RTOS_RESPONSE_BUCKETS_PER_DEADLINE) / deadline);
+    if (bucket >= RTOS_RESPONSE_BUCKETS) {
+        bucket = RTOS_RESPONSE_BUCKETS - 1U;
+    }
+    thread->response_histogram[bucket]++;
+}
+
 void rtos_delay(uint32_t ticks)
 {
-    disable_irq();
+    uint32_t const basepri = rtos_critical_enter();
 
     /* never call rtos_delay from the idle thread */
-    DBC_REQUIRE(rtos_current != rtos_threads[0]);
+    DBC_REQUIRE(rtos_current != &idle_thread);
+
+    RTOS_TRACE(RTOS_TRACE_DELAY, rtos_current, ticks);
+    rtos_ready_remove(rtos_current);
+    rtos_delayed_insert(rtos_current, ticks);
+    rtos_schedule();
+
+    rtos_critical_exit(basepri);
+}
+
+void rtos_delay_until(uint32_t *const last_wake, uint32_t const period)
+{
+    DBC_REQUIRE(last_wake != NULL);
+    DBC_REQUIRE(period != 0U);
+
+    uint32_t const basepri = rtos_critical_enter();
+
+    /* never call rtos_delay_until from the idle thread */
+    DBC_REQUIRE(rtos_current != &idle_thread);
+
+    /* This period's work is done */
+    rtos_thread_activation_end_locked(rtos_current);
+
+    /* The next release is relative to the last one rather than to now, so the period doesn't
+     * drift with the time spent running (or waiting to run) */
+    uint32_t const release = *last_wake + period;
+    *last_wake = release;
+
+    /* The difference is signed so the tick counter can wrap */
+    int32_t const remaining = (int32_t)(release - rtos_ticks);
+    if (remaining <= 0) {
+        /* Overran the period, run again straight away */
+        rtos_current->overruns++;
+        rtos_thread_activation_start_locked(rtos_current);
+        rtos_critical_exit(basepri);
+        return;
+    }
+
+    RTOS_TRACE(RTOS_TRACE_DELAY, rtos_current, remaining);
+    rtos_ready_remove(rtos_current);
+    rtos_delayed_insert(rtos_current, (uint32_t)remaining);
+    rtos_schedule();
+
+    /* context switch happens once the critical section is exited */
+    rtos_critical_exit(basepri);
+    (void)rtos_critical_enter();
+
+    /* Latency from the tick releasing the thread to it running again */
+    uint32_t const latency = DWT->CYCCNT - rtos_current->release_cycles;
+    if (latency < rtos_current->latency_min) {
+        rtos_current->latency_min = latency;
+    }
+    if (latency > rtos_current->latency_max) {
+        rtos_current->latency_max = latency;
+    }
+
+    /* The next period's work starts */
+    rtos_thread_activation_start_locked(rtos_current);
+
+    rtos_critical_exit(basepri);
+}
 
-    uint32_t thread_bit = (1U << (rtos_current->priority - 1U));
-    rtos_current->timeout = ticks;
-    rtos_ready_set &= ~thread_bit;
-    rtos_delayed_set |= thread_bit;
+uint32_t rtos_tick_count(void) { return rtos_ticks; }
+
+uint32_t rtos_tick_lateness(uint32_t const tick)
+{
+    uint32_t const basepri = rtos_critical_enter();
+    uint32_t const late_ticks = rtos_ticks - tick;
+    uint32_t const lateness =
+        (late_ticks * rtos_tick_period_cycles) + (DWT->CYCCNT - rtos_tick_cycles);
+    rtos_critical_exit(basepri);
+    return lateness;
+}
+
+void rtos_thread_activation_start(void)
+{
+    uint32_t const basepri = rtos_critical_enter();
+
+    DBC_REQUIRE(rtos_current != NULL);
+    rtos_thread_activation_start_locked(rtos_current);
+
+    rtos_critical_exit(basepri);
+}
+
+void rtos_thread_activation_end(void)
+{
+    uint32_t const basepri = rtos_critical_enter();
+
+    DBC_REQUIRE(rtos_current != NULL);
+    rtos_thread_activation_end_locked(rtos_current);
+
+    rtos_critical_exit(basepri);
+}
+
+void rtos_thread_set_deadline(rtos_thread_t *const thread, uint32_t const cycles)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+
+    thread->deadline = cycles;
+    thread->response_min = UINT32_MAX;
+    thread->response_max = 0U;
+    thread->deadline_misses = 0U;
+    for (uint32_t i = 0U; i < RTOS_RESPONSE_BUCKETS; ++i) {
+        thread->response_histogram[i] = 0U;
+    }
+
+    rtos_critical_exit(basepri);
+}
+
+void rtos_thread_signal(rtos_thread_t *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    if (rtos_isr_is_zero_latency()) {
+        /* Can't enter a critical section from above it, so hand the signal over to PendSV */
+        thread->signal_deferred = true;
+        rtos_signal_deferred = true;
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+        return;
+    }
+
+    /* Save the previous mask, as this may be called from within a critical section */
+    uint32_t const basepri = rtos_critical_enter();
+    rtos_thread_signal_locked(thread);
+    rtos_critical_exit(basepri);
+}
+
+bool rtos_thread_wait(uint32_t const ticks)
+{
+    uint32_t const basepri = rtos_critical_enter();
+
+    /* never block the idle thread */
+    DBC_REQUIRE(rtos_current != &idle_thread);
+
+    if ((!rtos_current->signalled) && (ticks != 0U)) {
+        rtos_current->waiting_signal = true;
+        rtos_ready_remove(rtos_current);
+        if (ticks != RTOS_WAIT_FOREVER) {
+            rtos_delayed_insert(rtos_current, ticks);
+        }
+        rtos_schedule();
+
+        /* context switch happens once the critical section is exited */
+        rtos_critical_exit(basepri);
+        (void)rtos_critical_enter();
+
+        /* Still set if the wait timed out */
+        rtos_current->waiting_signal = false;
+    }
+
+    bool const signalled = rtos_current->signalled;
+    rtos_current->signalled = false;
+
+    rtos_critical_exit(basepri);
+    return signalled;
+}
+
+void rtos_sem_init(rtos_sem_t *const self, uint32_t const count)
+{
+    DBC_REQUIRE(self != NULL);
+
+    self->count = count;
+    self->waiting = NULL;
+}
+
+void rtos_sem_take(rtos_sem_t *const self)
+{
+    DBC_ALLEGE(rtos_sem_take_timeout(self, RTOS_WAIT_FOREVER));
+}
+
+bool rtos_sem_take_timeout(rtos_sem_t *const self, uint32_t const ticks)
+{
+    DBC_REQUIRE(self != NULL);
+
+    /* Save the previous mask, a non-blocking take may be called from a critical section */
+    uint32_t const basepri = rtos_critical_enter();
+
+    RTOS_TRACE(RTOS_TRACE_SEM_TAKE, rtos_current, (uint32_t)self & 0xFFFFU);
+    if (self->count > 0U) {
+        self->count--;
+        rtos_critical_exit(basepri);
+        return true;
+    }
+    if (ticks == 0U) {
+        rtos_critical_exit(basepri);
+        return false;
+    }
+
+    /* never block the idle thread, an isr, or from within a critical section */
+    DBC_REQUIRE(rtos_current != &idle_thread);
+    DBC_REQUIRE(__get_IPSR() == 0U);
+    DBC_REQUIRE(basepri == 0U);
+
+    /* Park the thread in the semaphore's waiting list */
+    RTOS_TRACE(RTOS_TRACE_SEM_BLOCK, rtos_current, (uint32_t)self & 0xFFFFU);
+    rtos_ready_remove(rtos_current);
+    rtos_wait_insert(&self->waiting, rtos_current);
+    if (ticks != RTOS_WAIT_FOREVER) {
+        rtos_delayed_insert(rtos_current, ticks);
+    }
+    rtos_schedule();
+
+    /* context switch happens once the critical section is exited */
+    rtos_critical_exit(basepri);
+    (void)rtos_critical_enter();
+
+    /* rtos_sem_give removes the thread from the waiting list, if it is still there the wait
+     * timed out */
+    bool const taken = (rtos_current->wait_list == NULL);
+    if (!taken) {
+        RTOS_TRACE(RTOS_TRACE_SEM_TIMEOUT, rtos_current, (uint32_t)self & 0xFFFFU);
+        rtos_wait_remove(rtos_current);
+    }
+
+    rtos_critical_exit(basepri);
+    return taken;
+}
+
+void rtos_sem_give(rtos_sem_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    /* Save the previous mask, as this may be called from within a critical section */
+    uint32_t const basepri = rtos_critical_enter();
+
+    RTOS_TRACE(RTOS_TRACE_SEM_GIVE, rtos_current, (uint32_t)self & 0xFFFFU);
+    if (self->waiting != NULL) {
+        /* Hand the count directly to the highest priority waiter */
+        rtos_thread_t *const thread = self->waiting;
+        DBC_ASSERT(thread->wait_list == &self->waiting);
+
+        rtos_wait_remove(thread);
+        thread->blocked_on = NULL;
+        rtos_delayed_remove(thread);
+        rtos_ready_insert(thread);
+        rtos_schedule();
+    } else {
+        self->count++;
+    }
+
+    rtos_critical_exit(basepri);
+}
+
+/* Move a thread to another priority, carrying over its place in the ready list or waiting list
+ * it is in. Requires a critical section */
+static void rtos_thread_set_priority(rtos_thread_t *const thread, uint8_t const priority)
+{
+    if (thread->priority == priority) {
+        return;
+    }
+
+    bool const ready = (thread->ready_next != NULL);
+    if (ready) {
+        rtos_ready_remove(thread);
+    }
+    rtos_thread_t **const wait_list = thread->wait_list;
+    if (wait_list != NULL) {
+        rtos_wait_remove(thread);
+    }
+
+    thread->priority = priority;
+
+    if (ready) {
+        rtos_ready_insert(thread);
+    }
+    if (wait_list != NULL) {
+        rtos_wait_insert(wait_list, thread);
+    }
+}
+
+/* Highest priority a thread should run at: its base priority, or that of the highest priority
+ * thread waiting on a mutex it owns */
+static uint8_t rtos_thread_inherited_priority(rtos_thread_t const *const thread)
+{
+    uint8_t priority = thread->base_priority;
+    for (rtos_mutex_t const *m = thread->held; m != NULL; m = m->next_held) {
+        /* The head of the waiting list is the highest priority waiter */
+        if ((m->waiting != NULL) && (m->waiting->priority > priority)) {
+            priority = m->waiting->priority;
+        }
+    }
+    return priority;
+}
+
+void rtos_mutex_init(rtos_mutex_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    self->owner = NULL;
+    self->nest = 0U;
+    self->waiting = NULL;
+    self->next_held = NULL;
+}
+
+void rtos_mutex_lock(rtos_mutex_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+
+    /* never block the idle thread */
+    DBC_REQUIRE(rtos_current != &idle_thread);
+
+    if (self->owner == NULL) {
+        self->owner = rtos_current;
+        self->nest = 1U;
+        self->next_held = rtos_current->held;
+        rtos_current->held = self;
+        rtos_critical_exit(basepri);
+        return;
+    }
+    if (self->owner == rtos_current) {
+        self->nest++;
+        rtos_critical_exit(basepri);
+        return;
+    }
+
+    /* Park the thread in the mutex's waiting list */
+    rtos_ready_remove(rtos_current);
+    rtos_wait_insert(&self->waiting, rtos_current);
+    rtos_current->blocked_on = self;
+
+    /* Owner inherits the waiter's priority, and passes it on to the owner of any mutex it is
+     * blocked on in turn */
+    rtos_mutex_t const *mutex = self;
+    for (uint32_t depth = 0U; (mutex != NULL) && (depth < RTOS_MUTEX_INHERIT_DEPTH); ++depth) {
+        rtos_thread_t *const owner = mutex->owner;
+        /* a thread can't wait on itself through a chain of mutexes */
+        DBC_ASSERT(owner != rtos_current);
+        if (rtos_current->priority <= owner->priority) {
+            break;
+        }
+        rtos_thread_set_priority(owner, rtos_current->priority);
+        mutex = owner->blocked_on;
+    }
     rtos_schedule();
 
-    enable_irq();
+    /* context switch happens once the critical section is exited */
+    rtos_critical_exit(basepri);
+
+    /* rtos_mutex_unlock hands ownership over before waking the thread */
+    DBC_ENSURE(self->owner == rtos_current);
+}
+
+void rtos_mutex_unlock(rtos_mutex_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+
+    DBC_REQUIRE(self->owner == rtos_current);
+    if (--self->nest > 0U) {
+        rtos_critical_exit(basepri);
+        return;
+    }
+
+    /* Remove from the owner's held list */
+    rtos_mutex_t **link = &rtos_current->held;
+    while (*link != self) {
+        DBC_ASSERT(*link != NULL);
+        link = &(*link)->next_held;
+    }
+    *link = self->next_held;
+    self->next_held = NULL;
+
+    /* Drop the priority inherited through this mutex */
+    rtos_thread_set_priority(rtos_current, rtos_thread_inherited_priority(rtos_current));
+
+    if (self->waiting != NULL) {
+        /* Hand ownership directly to the highest priority waiter */
+        rtos_thread_t *const thread = self->waiting;
+        DBC_ASSERT(thread->wait_list == &self->waiting);
+
+        rtos_wait_remove(thread);
+        rtos_ready_insert(thread);
+
+        self->owner = thread;
+        self->nest = 1U;
+        self->next_held = thread->held;
+        thread->held = self;
+    } else {
+        self->owner = NULL;
+    }
+    rtos_schedule();
+
+    rtos_critical_exit(basepri);
+}
+
+rtos_thread_t *rtos_thread_self(void) { return rtos_current; }
+
+uint32_t rtos_thread_load(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    uint32_t const cycles = thread->load_cycles;
+    uint32_t const window = rtos_window_cycles;
+    rtos_critical_exit(basepri);
+
+    if (window == 0U) {
+        return 0U;
+    }
+    return (uint32_t)(((uint64_t)cycles * RTOS_LOAD_SCALE) / window);
+}
+
+uint32_t rtos_thread_jitter(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    uint32_t const jitter = (thread->latency_max >= thread->latency_min)
+        ? (thread->latency_max - thread->latency_min)
+        : 0U;
+    rtos_critical_exit(basepri);
+    return jitter;
+}
+
+uint32_t rtos_thread_overruns(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    return thread->overruns;
+}
+
+uint32_t rtos_thread_stack_used(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    return thread->stack_used;
+}
+
+uint32_t rtos_thread_response_min(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    /* Reported as 0 until the first activation has ended */
+    return (thread->response_min <= thread->response_max) ? thread->response_min : 0U;
+}
+
+uint32_t rtos_thread_response_max(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    return thread->response_max;
+}
+
+uint32_t rtos_thread_deadline_misses(rtos_thread_t const *const thread)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    return thread->deadline_misses;
+}
+
+void rtos_thread_response_histogram(
+    rtos_thread_t const *const thread,
+    uint32_t histogram[RTOS_RESPONSE_BUCKETS])
+{
+    DBC_REQUIRE(thread != NULL);
+    DBC_REQUIRE(histogram != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    for (uint32_t i = 0U; i < RTOS_RESPONSE_BUCKETS; ++i) {
+        histogram[i] = thread->response_histogram[i];
+    }
+    rtos_critical_exit(basepri);
+}
+
+rtos_thread_t *rtos_thread_idle(void) { return &idle_thread; }
+
+void rtos_thread_set_time_slice(rtos_thread_t *const thread, uint32_t const ticks)
+{
+    DBC_REQUIRE(thread != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    thread->time_slice = ticks;
+    thread->slice_remaining = ticks;
+    rtos_critical_exit(basepri);
+}
+
+uint32_t rtos_cpu_load(void)
+{
+    uint32_t const idle_load = rtos_thread_load(&idle_thread);
+    return (idle_load < RTOS_LOAD_SCALE) ? (RTOS_LOAD_SCALE - idle_load) : 0U;
 }
 
 void rtos_thread_create(
@@ -122,8 +1045,13 @@ void rtos_thread_create(
     uint32_t const stack_size,
     uint8_t const priority)
 {
-    DBC_REQUIRE(priority < (sizeof(rtos_threads) / sizeof(rtos_threads[0U])));
-    DBC_REQUIRE(rtos_threads[priority] == NULL);
+    DBC_REQUIRE(priority < RTOS_PRIORITY_COUNT);
+    /* Only the idle thread runs at the idle priority */
+    DBC_REQUIRE((priority != RTOS_IDLE_THREAD_PRIORITY) || (self == &idle_thread));
+    /* The bottom of the stack is the guard region, so it must be aligned to it (see
+     * RTOS_THREAD_STACK) */
+    DBC_REQUIRE(((uint32_t)stack_base % RTOS_STACK_GUARD_SIZE) == 0U);
+    DBC_REQUIRE(stack_size > (RTOS_STACK_GUARD_SIZE + (17U * sizeof(uint32_t))));
 
     /* get stack pointer and ensure aligned at the 8 byte boudary */
     uint32_t *sp = (uint32_t *)((((uint32_t)stack_base + stack_size) / 8U) * 8U);
@@ -140,6 +1068,8 @@ void rtos_thread_create(
     *(--sp) = 0x00000000U;       /* R0 */
 
     /* Initialise Additional Registers on Stack */
+    *(--sp) = 0xFFFFFFF9U; /* EXC_RETURN, return to thread mode on the main stack without an FPU
+                              frame */
     *(--sp) = 0x0000000BU; /* R11 */
     *(--sp) = 0x0000000AU; /* R10 */
     *(--sp) = 0x00000009U; /* R9 */
@@ -152,35 +1082,97 @@ void rtos_thread_create(
     /* Save current stack pointer into self */
     self->sp = sp;
 
-    /* Get aligned bottom of stack */
-    uint32_t *stack_limit = (uint32_t *)(((((uint32_t)stack_base - 1U) / 8U) + 1U) * 8U);
+    /* Get bottom of stack, above the guard region */
+    uint32_t *stack_limit = (uint32_t *)((uint32_t)stack_base + RTOS_STACK_GUARD_SIZE);
 
     /* pre-fill rest of stack with stack paint */
     for (sp = (sp - 1U); sp >= stack_limit; --sp) {
-        *sp = 0xBABECAFE;
+        *sp = RTOS_STACK_PAINT;
     }
+    self->stack_limit = stack_limit;
+    self->stack_top = (uint32_t *)((((uint32_t)stack_base + stack_size) / 8U) * 8U);
+    self->stack_used = 0U;
 
 
     /* Register thread with OS */
-    rtos_threads[priority] = self;
     self->priority = priority;
-    /* Mark thread as ready to run */
-    if (priority > 0U) {
-        rtos_ready_set |= (1U << (priority - 1U));
+    self->base_priority = priority;
+    self->wait_list = NULL;
+    self->wait_next = NULL;
+    self->held = NULL;
+    self->blocked_on = NULL;
+    self->timeout = 0U;
+    self->delay_next = NULL;
+    self->delay_prev = NULL;
+    self->cycles = 0U;
+    self->load_cycles = 0U;
+    self->release_cycles = 0U;
+    self->latency_min = UINT32_MAX;
+    self->latency_max = 0U;
+    self->overruns = 0U;
+    self->time_slice = RTOS_TIME_SLICE_TICKS;
+    self->slice_remaining = RTOS_TIME_SLICE_TICKS;
+    self->deadline = 0U;
+    self->response_min = UINT32_MAX;
+    self->response_max = 0U;
+    self->deadline_misses = 0U;
+    for (uint32_t i = 0U; i < RTOS_RESPONSE_BUCKETS; ++i) {
+        self->response_histogram[i] = 0U;
     }
+
+    uint32_t const basepri = rtos_critical_enter();
+
+    /* Append to the thread list, so the stack scanner visits threads in creation order */
+    rtos_thread_t **link = &rtos_thread_list;
+    uint8_t id = 0U;
+    while (*link != NULL) {
+        DBC_REQUIRE(*link != self);
+        link = &(*link)->list_next;
+        id++;
+    }
+    /* Ids above are reserved for RTOS_TRACE_NO_THREAD */
+    DBC_REQUIRE(id < UINT8_MAX);
+    self->id = id;
+    self->list_next = NULL;
+    *link = self;
+
+    /* Mark thread as ready to run */
+    self->ready_next = NULL;
+    self->ready_prev = NULL;
+    self->activation_started = false;
+    self->activation_woken = false;
+    rtos_ready_insert(self);
+
+    /* Starting up isn't an activation, the first is released when the thread is first woken */
+    self->activation_woken = false;
+    self->activation_cycles = DWT->CYCCNT;
+
+    rtos_critical_exit(basepri);
 }
 
-void PendSV_Handler(void)
+__attribute__((naked)) void PendSV_Handler(void)
 {
     asm volatile(
-        /* disable interrupts */
+        /* enter a critical section, leaving zero-latency interrupts enabled */
+        "    mov   r0,#" STRINGIZE(RTOS_KERNEL_BASEPRI) "\n\t"
         "    cpsid i\n\t"
+        "    msr   basepri,r0\n\t"
+        "    cpsie i\n\t"
+        /* rtos_thread_switch_hook(); (preserving EXC_RETURN in lr) */
+        "    push  {r0,lr}\n\t"
+        "    bl    rtos_thread_switch_hook\n\t"
+        "    pop   {r0,lr}\n\t"
         /* if {rtos_current != (rtos_thread_t *)0U) { */
         "    ldr   r1,=rtos_current\n\t"
         "    ldr   r1,[r1,#0]\n\t"
         "    cbz   r1,PendSV_restore\n\t"
-        /* push r4-r11 onto the stack */
-        "    push  {r4-r11}\n\t"
+        /* if the thread used the fpu (EXC_RETURN bit 4 clear), push s16-s31, s0-s15 are in the
+         * (lazily stacked) exception frame */
+        "    tst   lr,#0x10\n\t"
+        "    it    eq\n\t"
+        "    vpusheq {s16-s31}\n\t"
+        /* push r4-r11 and EXC_RETURN onto the stack */
+        "    push  {r4-r11,lr}\n\t"
         "    ldr   r1,=rtos_current\n\t"
         "    ldr   r1,[r1,#0]\n\t"
         /* rtos_current->sp = sp; */
@@ -197,9 +1189,15 @@ void PendSV_Handler(void)
         "    ldr   r1,[r1,#0]\n\t"
         "    ldr   r2,=rtos_current\n\t"
         "    str   r1,[r2,#0]\n\t"
-        /* pop registers r4-r11 */
-        "    pop   {r4-r11}\n\t"
-        "    cpsie i\n\t"
+        /* pop registers r4-r11 and EXC_RETURN */
+        "    pop   {r4-r11,lr}\n\t"
+        /* pop s16-s31 if the thread used the fpu */
+        "    tst   lr,#0x10\n\t"
+        "    it    eq\n\t"
+        "    vpopeq {s16-s31}\n\t"
+        /* exit the critical section */
+        "    mov   r0,#0\n\t"
+        "    msr   basepri,r0\n\t"
         "    bx    lr\n\t");
 
 #if 0
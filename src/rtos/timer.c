@@ -0,0 +1,172 @@
+#include "rtos/timer.h"
+
+#include "rtos/critical.h"
+#include "rtos/thread.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static rtos_thread_t rtos_timer_thread = {0};
+static RTOS_THREAD_STACK(rtos_timer_stack, RTOS_TIMER_STACK_SIZE);
+
+/* Active timers, sorted by expiry */
+static rtos_timer_t *rtos_timers = NULL;
+
+/* Insert a timer in expiry order, after timers expiring on the same tick. Requires a critical
+ * section */
+static void rtos_timer_insert(rtos_timer_t *const self)
+{
+    rtos_timer_t **link = &rtos_timers;
+    /* The difference is signed so the tick counter can wrap */
+    while ((*link != NULL) && ((int32_t)((*link)->expiry - self->expiry) <= 0)) {
+        link = &(*link)->next;
+    }
+    self->next = *link;
+    *link = self;
+    self->active = true;
+}
+
+/* Remove a timer from the active list, if it is in it. Requires a critical section */
+static void rtos_timer_remove(rtos_timer_t *const self)
+{
+    if (!self->active) {
+        return;
+    }
+
+    rtos_timer_t **link = &rtos_timers;
+    while (*link != self) {
+        DBC_ASSERT(*link != NULL);
+        link = &(*link)->next;
+    }
+    *link = self->next;
+    self->next = NULL;
+    self->active = false;
+}
+
+static void rtos_timer_thread_handler(void)
+{
+    for (;;) {
+        uint32_t const basepri = rtos_critical_enter();
+
+        uint32_t timeout = RTOS_WAIT_FOREVER;
+        rtos_timer_t *const timer = rtos_timers;
+        if (timer != NULL) {
+            int32_t const remaining = (int32_t)(timer->expiry - rtos_tick_count());
+            if (remaining <= 0) {
+                /* Latency from the tick the timer expired on to its callback running */
+                uint32_t const latency = rtos_tick_lateness(timer->expiry);
+                if (latency < timer->latency_min) {
+                    timer->latency_min = latency;
+                }
+                if (latency > timer->latency_max) {
+                    timer->latency_max = latency;
+                }
+
+                /* Re-arm periodic timers before running the callback, so it can stop them */
+                rtos_timer_remove(timer);
+                if (timer->period != 0U) {
+                    timer->expiry += timer->period;
+                    if ((int32_t)(timer->expiry - rtos_tick_count()) <= 0) {
+                        timer->overruns++;
+                    }
+                    rtos_timer_insert(timer);
+                }
+                rtos_timer_callback_t const callback = timer->callback;
+                void *const arg = timer->arg;
+                rtos_critical_exit(basepri);
+
+                callback(arg);
+                continue;
+            }
+            timeout = (uint32_t)remaining;
+        }
+
+        rtos_critical_exit(basepri);
+
+        /* Sleep until the first timer expires, or a timer is started ahead of it */
+        (void)rtos_thread_wait(timeout);
+    }
+}
+
+void rtos_timer_service_init(uint8_t const priority)
+{
+    rtos_thread_create(
+        &rtos_timer_thread,
+        &rtos_timer_thread_handler,
+        rtos_timer_stack,
+        sizeof(rtos_timer_stack),
+        priority);
+}
+
+rtos_thread_t *rtos_timer_service_thread(void) { return &rtos_timer_thread; }
+
+void rtos_timer_init(rtos_timer_t *const self, rtos_timer_callback_t const callback, void *arg)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(callback != NULL);
+
+    self->callback = callback;
+    self->arg = arg;
+    self->expiry = 0U;
+    self->period = 0U;
+    self->active = false;
+    self->next = NULL;
+    self->latency_min = UINT32_MAX;
+    self->latency_max = 0U;
+    self->overruns = 0U;
+}
+
+void rtos_timer_start(rtos_timer_t *const self, uint32_t const delay, uint32_t const period)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(self->callback != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    rtos_timer_remove(self);
+    self->expiry = rtos_tick_count() + delay;
+    self->period = period;
+    rtos_timer_insert(self);
+    bool const first = (rtos_timers == self);
+    rtos_critical_exit(basepri);
+
+    /* The timer thread only needs waking if it is sleeping for longer than this timer */
+    if (first) {
+        rtos_thread_signal(&rtos_timer_thread);
+    }
+}
+
+void rtos_timer_stop(rtos_timer_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    rtos_timer_remove(self);
+    rtos_critical_exit(basepri);
+}
+
+bool rtos_timer_active(rtos_timer_t const *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    return self->active;
+}
+
+uint32_t rtos_timer_jitter(rtos_timer_t const *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    uint32_t const basepri = rtos_critical_enter();
+    uint32_t const jitter =
+        (self->latency_max >= self->latency_min) ? (self->latency_max - self->latency_min) : 0U;
+    rtos_critical_exit(basepri);
+    return jitter;
+}
+
+uint32_t rtos_timer_overruns(rtos_timer_t const *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    return self->overruns;
+}
@@ -0,0 +1,72 @@
+#include "rtos/trace.h"
+
+#include "hal/stm32f4_blackpill.h"
+#include "rtos/thread.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if (RTOS_TRACE_SIZE & (RTOS_TRACE_SIZE - 1U)) != 0U
+#error "RTOS_TRACE_SIZE must be a power of two!"
+#endif
+
+/* Ring buffer of the last RTOS_TRACE_SIZE records. rtos_trace_head counts every record since
+ * startup, so it indexes the buffer with a mask and never needs resetting */
+static rtos_trace_record_t rtos_trace_buffer[RTOS_TRACE_SIZE];
+static uint32_t rtos_trace_head = 0U;
+static volatile bool rtos_trace_stopped = false;
+
+void rtos_trace_record(
+    rtos_trace_event_t const event,
+    rtos_thread_t const *const thread,
+    uint32_t const arg)
+{
+    if (rtos_trace_stopped) {
+        return;
+    }
+
+    /* PRIMASK rather than a critical section, as events are recorded from zero-latency isrs */
+    uint32_t const primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t const slot = rtos_trace_head & (RTOS_TRACE_SIZE - 1U);
+    rtos_trace_record_t *const record = &rtos_trace_buffer[slot];
+    record->cycles = DWT->CYCCNT;
+    record->event = (uint8_t)event;
+    record->thread = (thread != NULL) ? thread->id : RTOS_TRACE_NO_THREAD;
+    record->arg = (arg > UINT16_MAX) ? UINT16_MAX : (uint16_t)arg;
+    rtos_trace_head++;
+
+    __set_PRIMASK(primask);
+}
+
+void rtos_trace_isr(rtos_trace_event_t const event)
+{
+    rtos_trace_record(event, rtos_thread_self(), __get_IPSR());
+}
+
+void rtos_trace_stop(void) { rtos_trace_stopped = true; }
+
+void rtos_trace_start(void) { rtos_trace_stopped = false; }
+
+uint32_t rtos_trace_count(void) { return rtos_trace_head; }
+
+bool rtos_trace_read(uint32_t const index, rtos_trace_record_t *const record)
+{
+    DBC_REQUIRE(record != NULL);
+
+    uint32_t const primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* The difference is unsigned so the count can wrap */
+    uint32_t const age = rtos_trace_head - index;
+    bool const available = (age > 0U) && (age <= RTOS_TRACE_SIZE);
+    if (available) {
+        *record = rtos_trace_buffer[index & (RTOS_TRACE_SIZE - 1U)];
+    }
+
+    __set_PRIMASK(primask);
+    return available;
+}
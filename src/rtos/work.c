@@ -0,0 +1,103 @@
+#include "rtos/work.h"
+
+#include "hal/stm32f4_blackpill.h"
+#include "rtos/thread.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static rtos_thread_t rtos_work_thread = {0};
+static RTOS_THREAD_STACK(rtos_work_stack, RTOS_WORK_STACK_SIZE);
+
+/* Submitted work, most recently submitted first. Pushed to with LDREX/STREX so isrs of any
+ * priority can submit without a critical section, and taken as a whole by the work thread */
+static rtos_work_t *volatile rtos_work_submitted = NULL;
+
+/* Take every submitted work item, oldest first */
+static rtos_work_t *rtos_work_take(void)
+{
+    rtos_work_t *list = NULL;
+    do {
+        list = (rtos_work_t *)__LDREXW((volatile uint32_t *)&rtos_work_submitted);
+    } while (__STREXW(0U, (volatile uint32_t *)&rtos_work_submitted) != 0U);
+
+    /* Reverse into submission order */
+    rtos_work_t *ordered = NULL;
+    while (list != NULL) {
+        rtos_work_t *const next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    return ordered;
+}
+
+static void rtos_work_thread_handler(void)
+{
+    for (;;) {
+        /* Signalled by rtos_work_submit, a submission while the queue is being run leaves the
+         * signal set so nothing is missed */
+        (void)rtos_thread_wait(RTOS_WAIT_FOREVER);
+
+        rtos_work_t *work = rtos_work_take();
+        while (work != NULL) {
+            /* Read the link before clearing pending, as the work can then be submitted again */
+            rtos_work_t *const next = work->next;
+            rtos_work_handler_t const handler = work->handler;
+            void *const arg = work->arg;
+            __DMB();
+            work->pending = 0U;
+
+            handler(arg);
+            work = next;
+        }
+    }
+}
+
+void rtos_work_service_init(uint8_t const priority)
+{
+    rtos_thread_create(
+        &rtos_work_thread,
+        &rtos_work_thread_handler,
+        rtos_work_stack,
+        sizeof(rtos_work_stack),
+        priority);
+}
+
+rtos_thread_t *rtos_work_service_thread(void) { return &rtos_work_thread; }
+
+void rtos_work_init(rtos_work_t *const self, rtos_work_handler_t const handler, void *arg)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(handler != NULL);
+
+    self->handler = handler;
+    self->arg = arg;
+    self->pending = 0U;
+    self->next = NULL;
+}
+
+bool rtos_work_submit(rtos_work_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(self->handler != NULL);
+
+    /* Claim the work, only one submitter can queue it */
+    do {
+        if (__LDREXW(&self->pending) != 0U) {
+            __CLREX();
+            return false;
+        }
+    } while (__STREXW(1U, &self->pending) != 0U);
+
+    rtos_work_t *head = NULL;
+    do {
+        head = (rtos_work_t *)__LDREXW((volatile uint32_t *)&rtos_work_submitted);
+        self->next = head;
+    } while (__STREXW((uint32_t)self, (volatile uint32_t *)&rtos_work_submitted) != 0U);
+
+    rtos_thread_signal(&rtos_work_thread);
+    return true;
+}
@@ -1,24 +1,34 @@
 #include "utils/cbuf.h"
 
+#include "utils/dbc_assert.h"
 #include "utils/status.h"
 
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
-void cbuf_init(cbuf_t *const self)
+void cbuf_init(cbuf_t *const self, uint8_t *const storage, size_t const capacity)
 {
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(storage != NULL);
+    DBC_REQUIRE((capacity > 1) && ((capacity & (capacity - 1)) == 0));
+
     self->write = 0;
     self->read = 0;
+    self->buf = storage;
+    /* Indices wrap with a mask rather than a modulo */
+    self->mask = capacity - 1;
 }
 
+size_t cbuf_capacity(cbuf_t const *const self) { return self->mask; }
+
 status_t cbuf_put(cbuf_t *const self, uint8_t const value)
 {
-    if (((self->write + 1) % CBUF_SIZE) == self->read) {
+    if (((self->write + 1) & self->mask) == self->read) {
         return CBUF_STATUS_CBUF_FULL;
     }
     self->buf[self->write] = value;
-    self->write = (self->write + 1) % CBUF_SIZE;
+    self->write = (self->write + 1) & self->mask;
     return STATUS_OK;
 }
 
@@ -28,16 +38,56 @@ status_t cbuf_get(cbuf_t *const self, uint8_t *const value)
         return CBUF_STATUS_CBUF_EMPTY;
     }
     *value = self->buf[self->read];
-    self->read = (self->read + 1) % CBUF_SIZE;
+    self->read = (self->read + 1) & self->mask;
     return STATUS_OK;
 }
 
 size_t cbuf_size(cbuf_t const *const self)
 {
+    return (self->write - self->read) & self->mask;
+}
+
+void cbuf_peek_contiguous(cbuf_t const *const self, uint8_t const **const span, size_t *const size)
+{
+    DBC_REQUIRE(span != NULL);
+    DBC_REQUIRE(size != NULL);
+
+    *span = &self->buf[self->read];
     if (self->read <= self->write) {
-        return self->write - self->read;
+        *size = self->write - self->read;
+    } else {
+        *size = (self->mask + 1) - self->read;
     }
-    return (CBUF_SIZE - self->read) + self->write;
+}
+
+void cbuf_consume(cbuf_t *const self, size_t const size)
+{
+    DBC_REQUIRE(size <= cbuf_size(self));
+
+    self->read = (self->read + size) & self->mask;
+}
+
+void cbuf_reserve(cbuf_t *const self, uint8_t **const span, size_t *const size)
+{
+    DBC_REQUIRE(span != NULL);
+    DBC_REQUIRE(size != NULL);
+
+    *span = &self->buf[self->write];
+    if (self->write < self->read) {
+        *size = self->read - self->write - 1;
+    } else if (self->read == 0) {
+        /* Keep the last byte free, writing it would make write wrap onto read */
+        *size = self->mask - self->write;
+    } else {
+        *size = (self->mask + 1) - self->write;
+    }
+}
+
+void cbuf_commit(cbuf_t *const self, size_t const size)
+{
+    DBC_REQUIRE(size <= (cbuf_capacity(self) - cbuf_size(self)));
+
+    self->write = (self->write + size) & self->mask;
 }
 
 status_t cbuf_read(cbuf_t *const self, size_t const size, uint8_t dest[size])
@@ -49,33 +99,36 @@ status_t cbuf_read(cbuf_t *const self, size_t const size, uint8_t dest[size])
         return CBUF_STATUS_BUFFER_OVERFLOW;
     }
 
-    if (self->read < self->write) {
-        memcpy(&dest[0], &self->buf[self->read], size);
-        self->read += size;
-    } else {
-        size_t temp_size = CBUF_SIZE - self->read;
-        memcpy(&dest[0], &self->buf[self->read], temp_size);
-        memcpy(&dest[temp_size], &self->buf[0], size - temp_size);
-        self->read = size - temp_size;
+    /* At most two spans, up to the end of the storage and then from the start */
+    size_t done = 0;
+    while (done < size) {
+        uint8_t const *span = NULL;
+        size_t span_size = 0;
+        cbuf_peek_contiguous(self, &span, &span_size);
+        size_t const n = ((size - done) < span_size) ? (size - done) : span_size;
+        memcpy(&dest[done], span, n);
+        cbuf_consume(self, n);
+        done += n;
     }
 
     return STATUS_OK;
 }
 
-status_t cbuf_write(cbuf_t *const self, size_t const size, uint8_t const dest[size])
+status_t cbuf_write(cbuf_t *const self, size_t const size, uint8_t const src[size])
 {
-    if (size > (CBUF_SIZE - cbuf_size(self))) {
+    if (size > (cbuf_capacity(self) - cbuf_size(self))) {
         return CBUF_STATUS_BUFFER_OVERFLOW;
     }
 
-    if (self->write + size < CBUF_SIZE) {
-        memcpy(&self->buf[self->write], &dest[0], size);
-        self->write += size;
-    } else {
-        size_t temp_size = CBUF_SIZE - self->write;
-        memcpy(&self->buf[self->write], &dest[0], temp_size);
-        memcpy(&self->buf[0], &dest[temp_size], size - temp_size);
-        self->write = size - temp_size;
+    size_t done = 0;
+    while (done < size) {
+        uint8_t *span = NULL;
+        size_t span_size = 0;
+        cbuf_reserve(self, &span, &span_size);
+        size_t const n = ((size - done) < span_size) ? (size - done) : span_size;
+        memcpy(span, &src[done], n);
+        cbuf_commit(self, n);
+        done += n;
     }
 
     return STATUS_OK;
@@ -1,25 +1,75 @@
 #include "utils/debug.h"
 
+#include "hal/stm32f4_blackpill.h"
 #include "hal/uart.h"
+#include "rtos/thread.h"
 #include "utils/dbc_assert.h"
 #include "utils/status.h"
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 static uart_id_t debug_uart_id = UART2;
 
+/* Serialises output from multiple threads so lines aren't interleaved */
+static rtos_mutex_t debug_mutex = {0};
+
+/* Only lock from threads, debug output from isrs or before the rtos is running is written
+ * directly */
+static inline bool debug_lock(void)
+{
+    rtos_thread_t *const self = rtos_thread_self();
+    if ((__get_IPSR() != 0U) || (self == NULL) || (self->base_priority == 0U)) {
+        return false;
+    }
+    rtos_mutex_lock(&debug_mutex);
+    return true;
+}
+
+static inline void debug_unlock(bool const locked)
+{
+    if (locked) {
+        rtos_mutex_unlock(&debug_mutex);
+    }
+}
+
+/* Queue a constant string to be sent by dma without copying it, falling back to the byte queue
+ * if too many buffers are already in flight */
+static void debug_write_const_str(char const *const str)
+{
+    size_t const len = strlen(str);
+    if ((len == 0)
+        || (uart_write_buf_async(debug_uart_id, (uint32_t)len, (uint8_t const *)str, NULL)
+            != STATUS_OK)) {
+        uart_write_str(debug_uart_id, str);
+    }
+}
+
+/* Queue a caller's message, copied into the byte queue unless it is a string literal */
+static void debug_write_msg(char const *const msg, bool const literal)
+{
+    if (literal) {
+        debug_write_const_str(msg);
+    } else {
+        uart_write_str(debug_uart_id, msg);
+    }
+}
+
 void debug_init(uart_id_t const uart_id, uint32_t const baud)
 {
     debug_uart_id = uart_id;
+    rtos_mutex_init(&debug_mutex);
     uart_init(debug_uart_id, baud);
 }
 
-void debug_status(char const *const msg, status_t status)
+static void debug_status_msg(char const *const msg, status_t status, bool const literal)
 {
     DBC_REQUIRE(msg != NULL);
-    uart_write_str(debug_uart_id, msg);
-    uart_write_str(debug_uart_id, " (0x");
+    bool const locked = debug_lock();
+    debug_write_msg(msg, literal);
+    debug_write_const_str(" (0x");
 #ifdef STATUS_ENUM_GREATER_THAN_UINT8 /* Code for bigger status values */
     for (int i = 3; i < 0; --i) {
         uint8_t byte = (((uint32_t)status) >> (i * 8)) & 0xFF;
@@ -29,43 +79,79 @@ void debug_status(char const *const msg, status_t status)
     DBC_REQUIRE(STATUS_MAX <= 0xFF);
     uart_write_hex_byte(debug_uart_id, (uint8_t)(status & 0xFF));
 #endif
-    uart_write_str(debug_uart_id, ")\r\n");
+    debug_write_const_str(")\r\n");
+    debug_unlock(locked);
 }
 
-void debug_str(char const *const msg)
+static void debug_str_msg(char const *const msg, bool const literal)
 {
     DBC_REQUIRE(msg != NULL);
-    uart_write_str(debug_uart_id, msg);
-    uart_write_str(debug_uart_id, "\r\n");
+    bool const locked = debug_lock();
+    debug_write_msg(msg, literal);
+    debug_write_const_str("\r\n");
+    debug_unlock(locked);
 }
 
-void debug_int(char const *const msg, uint32_t value)
+static void debug_int_msg(char const *const msg, uint32_t value, bool const literal)
 {
     DBC_REQUIRE(msg != NULL);
-    uart_write_str(debug_uart_id, msg);
-    uart_write_str(debug_uart_id, " (0x");
+    bool const locked = debug_lock();
+    debug_write_msg(msg, literal);
+    debug_write_const_str(" (0x");
     for (int i = 3; i >= 0; --i) {
         uint8_t byte = (((uint32_t)value) >> (i * 8)) & 0xFF;
         uart_write_hex_byte(debug_uart_id, byte);
     }
-    uart_write_str(debug_uart_id, ")\r\n");
+    debug_write_const_str(")\r\n");
+    debug_unlock(locked);
 }
 
-void debug_hex(char const *const msg, uint32_t const size, uint8_t const buf[size])
+static void debug_hex_msg(
+    char const *const msg,
+    uint32_t const size,
+    uint8_t const buf[size],
+    bool const literal)
 {
     DBC_REQUIRE(size > 0U);
     DBC_REQUIRE(buf != NULL);
     DBC_REQUIRE(msg != NULL);
-    uart_write_str(debug_uart_id, msg);
-    uart_write_str(debug_uart_id, ":\r\n");
+    bool const locked = debug_lock();
+    debug_write_msg(msg, literal);
+    debug_write_const_str(":\r\n");
 
     for (uint32_t i = 0; i < size; ++i) {
         uart_write_hex_byte(debug_uart_id, buf[i]);
         /* print a newline every 16th byte, or on the last byte */
         if (((i > 0) && ((i % 16) == 0)) || (i == (size - 1))) {
-            uart_write_str(debug_uart_id, "\r\n");
+            debug_write_const_str("\r\n");
         } else {
             uart_write_byte(debug_uart_id, ' ');
         }
     }
+    debug_unlock(locked);
+}
+
+void debug_status(char const *const msg, status_t status) { debug_status_msg(msg, status, false); }
+
+void debug_str(char const *const msg) { debug_str_msg(msg, false); }
+
+void debug_int(char const *const msg, uint32_t value) { debug_int_msg(msg, value, false); }
+
+void debug_hex(char const *const msg, uint32_t const size, uint8_t const buf[size])
+{
+    debug_hex_msg(msg, size, buf, false);
+}
+
+void debug_status_literal(char const *const msg, status_t status)
+{
+    debug_status_msg(msg, status, true);
+}
+
+void debug_str_literal(char const *const msg) { debug_str_msg(msg, true); }
+
+void debug_int_literal(char const *const msg, uint32_t value) { debug_int_msg(msg, value, true); }
+
+void debug_hex_literal(char const *const msg, uint32_t const size, uint8_t const buf[size])
+{
+    debug_hex_msg(msg, size, buf, true);
 }
@@ -0,0 +1,148 @@
+#include "utils/pool.h"
+
+#include "hal/stm32f4_blackpill.h"
+#include "utils/dbc_assert.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Registered size classes, in increasing block size */
+static pool_t *pool_classes[POOL_CLASS_MAX] = {0};
+static uint32_t pool_class_count = 0U;
+
+/* Count a block in or out of use and track the high-water mark. LDREX/STREX like the free
+ * stack, so the counters stay consistent when isrs allocate and free */
+static void pool_used_add(pool_t *const self, int32_t const delta)
+{
+    uint32_t used = 0U;
+    do {
+        used = __LDREXW(&self->used) + (uint32_t)delta;
+    } while (__STREXW(used, &self->used) != 0U);
+
+    uint32_t used_max = 0U;
+    do {
+        used_max = __LDREXW(&self->used_max);
+        if (used <= used_max) {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW(used, &self->used_max) != 0U);
+}
+
+void pool_init(
+    pool_t *const self,
+    void *const storage,
+    size_t const block_size,
+    uint32_t const count)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(storage != NULL);
+    DBC_REQUIRE(block_size >= sizeof(pool_block_t));
+    DBC_REQUIRE((block_size % sizeof(uint32_t)) == 0U);
+    DBC_REQUIRE(((uintptr_t)storage % sizeof(uint32_t)) == 0U);
+    DBC_REQUIRE(count > 0U);
+
+    self->start = storage;
+    self->end = self->start + (block_size * count);
+    self->block_size = block_size;
+    self->count = count;
+    self->used = 0U;
+    self->used_max = 0U;
+    self->fail_count = 0U;
+
+    /* Link the blocks in address order, so the first allocations come from the start */
+    pool_block_t *free = NULL;
+    for (uint32_t i = count; i > 0U; --i) {
+        pool_block_t *const block = (pool_block_t *)(self->start + ((i - 1U) * block_size));
+        block->next = free;
+        free = block;
+    }
+    self->free = free;
+}
+
+void *pool_block_alloc(pool_t *const self)
+{
+    DBC_REQUIRE(self != NULL);
+
+    /* The exclusive monitor is cleared by every exception entry and return, so a pop and push of
+     * the same block by a preempting isr or thread between the LDREX and STREX fails the STREX
+     * rather than corrupting the stack (no ABA problem on a single core) */
+    pool_block_t *block = NULL;
+    do {
+        block = (pool_block_t *)__LDREXW((volatile uint32_t *)&self->free);
+        if (block == NULL) {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW((uint32_t)block->next, (volatile uint32_t *)&self->free) != 0U);
+
+    if (block == NULL) {
+        uint32_t fail_count = 0U;
+        do {
+            fail_count = __LDREXW(&self->fail_count) + 1U;
+        } while (__STREXW(fail_count, &self->fail_count) != 0U);
+        return NULL;
+    }
+
+    pool_used_add(self, 1);
+    return block;
+}
+
+void pool_block_free(pool_t *const self, void *const block)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(((uint8_t *)block >= self->start) && ((uint8_t *)block < self->end));
+    /* In range, so the offset is non-negative */
+    DBC_REQUIRE(((size_t)((uint8_t *)block - self->start) % self->block_size) == 0U);
+
+    pool_block_t *const freed = block;
+    do {
+        freed->next = (pool_block_t *)__LDREXW((volatile uint32_t *)&self->free);
+    } while (__STREXW((uint32_t)freed, (volatile uint32_t *)&self->free) != 0U);
+
+    pool_used_add(self, -1);
+}
+
+void pool_register(pool_t *const pool)
+{
+    DBC_REQUIRE(pool != NULL);
+    DBC_REQUIRE(pool_class_count < POOL_CLASS_MAX);
+    DBC_REQUIRE(
+        (pool_class_count == 0U) ||
+        (pool_classes[pool_class_count - 1U]->block_size < pool->block_size));
+
+    pool_classes[pool_class_count] = pool;
+    pool_class_count++;
+}
+
+void *pool_alloc(size_t const size)
+{
+    /* Fall back to a larger class when the best fit is empty, there are only POOL_CLASS_MAX */
+    for (uint32_t i = 0U; i < pool_class_count; ++i) {
+        if (pool_classes[i]->block_size < size) {
+            continue;
+        }
+        void *const block = pool_block_alloc(pool_classes[i]);
+        if (block != NULL) {
+            return block;
+        }
+    }
+    return NULL;
+}
+
+void pool_free(void *const block)
+{
+    DBC_REQUIRE(block != NULL);
+
+    for (uint32_t i = 0U; i < pool_class_count; ++i) {
+        pool_t *const pool = pool_classes[i];
+        if (((uint8_t *)block >= pool->start) && ((uint8_t *)block < pool->end)) {
+            pool_block_free(pool, block);
+            return;
+        }
+    }
+
+    /* Not allocated by pool_alloc */
+    DBC_ERROR();
+}
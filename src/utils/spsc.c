@@ -0,0 +1,130 @@
+#include "utils/spsc.h"
+
+#include "hal/stm32f4_blackpill.h"
+#include "utils/dbc_assert.h"
+#include "utils/status.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Ordering
+ * - The producer fills the storage, then DMBs before moving head, so the consumer never sees
+ *   head cover bytes that aren't written yet
+ * - The consumer DMBs after reading head before reading the storage, and again after copying
+ *   the bytes out before moving tail, so the producer never overwrites bytes still being read
+ */
+
+void spsc_init(spsc_t *const self, uint8_t *const storage, uint32_t const capacity)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(storage != NULL);
+    DBC_REQUIRE((capacity > 0U) && ((capacity & (capacity - 1U)) == 0U));
+
+    self->head = 0U;
+    self->tail = 0U;
+    self->dropped = 0U;
+    self->overruns = 0U;
+    self->lag = 0U;
+    self->buf = storage;
+    self->mask = capacity - 1U;
+}
+
+void spsc_set_lag(spsc_t *const self, uint32_t const lag)
+{
+    DBC_REQUIRE(self != NULL);
+    DBC_REQUIRE(lag <= self->mask);
+
+    self->lag = lag;
+}
+
+/* Whether the producer may have overwritten bytes from tail, its unpublished writes included */
+static inline bool spsc_lapped(spsc_t const *const self, uint32_t const tail)
+{
+    return ((self->head - tail) + self->lag) > (self->mask + 1U);
+}
+
+uint32_t spsc_count(spsc_t const *const self) { return self->head - self->tail; }
+
+uint32_t spsc_space(spsc_t const *const self) { return (self->mask + 1U) - spsc_count(self); }
+
+bool spsc_put(spsc_t *const self, uint8_t const value)
+{
+    uint32_t const head = self->head;
+    if ((head - self->tail) > self->mask) {
+        self->dropped++;
+        return false;
+    }
+    __DMB();
+
+    self->buf[head & self->mask] = value;
+    __DMB();
+    self->head = head + 1U;
+    return true;
+}
+
+void spsc_produce_to(spsc_t *const self, uint32_t const offset)
+{
+    DBC_REQUIRE(offset <= self->mask);
+
+    uint32_t const head = self->head;
+    __DMB();
+    self->head = head + ((offset - head) & self->mask);
+}
+
+bool spsc_get(spsc_t *const self, uint8_t *const value)
+{
+    uint32_t const tail = self->tail;
+    if (self->head == tail) {
+        return false;
+    }
+    __DMB();
+
+    *value = self->buf[tail & self->mask];
+    __DMB();
+    self->tail = tail + 1U;
+    return true;
+}
+
+/* Drop everything the producer has published, after it lapped the consumer */
+static status_t spsc_resync(spsc_t *const self)
+{
+    self->overruns++;
+    self->tail = self->head;
+    return CBUF_STATUS_OVERRUN;
+}
+
+status_t spsc_read(spsc_t *const self, size_t const size, uint8_t dest[size])
+{
+    uint32_t const tail = self->tail;
+    uint32_t const count = self->head - tail;
+    if (spsc_lapped(self, tail)) {
+        return spsc_resync(self);
+    }
+    if (count == 0U) {
+        return CBUF_STATUS_CBUF_EMPTY;
+    }
+    if (size > count) {
+        return CBUF_STATUS_BUFFER_OVERFLOW;
+    }
+    __DMB();
+
+    /* At most two copies, up to the end of the storage and then from the start */
+    uint32_t const start = tail & self->mask;
+    size_t const first = ((start + size) <= (self->mask + 1U)) ? size : ((self->mask + 1U) - start);
+    memcpy(&dest[0], &self->buf[start], first);
+    memcpy(&dest[first], &self->buf[0], size - first);
+    __DMB();
+
+    /* The producer doesn't wait for the tail, so the bytes may have been overwritten while they
+     * were copied */
+    if (spsc_lapped(self, tail)) {
+        return spsc_resync(self);
+    }
+    self->tail = tail + (uint32_t)size;
+    return STATUS_OK;
+}
+
+uint32_t spsc_overruns(spsc_t const *const self) { return self->dropped + self->overruns; }
@@ -2,12 +2,27 @@ const c = @cImport({
     @cInclude("hal/systick.h");
     @cInclude("utils/debug.h");
     @cInclude("rtos/thread.h");
+    @cInclude("rtos/timer.h");
 });
 
 const p = @import("hal/pinutils.zig");
 const uart = @import("hal/uart.zig").Uart;
 const gpio = @import("hal/gpio.zig");
 
+const period: u32 = 250;
+// Exported for its jitter telemetry
+export var zig_timer: c.rtos_timer_t = undefined;
+var on: bool = true;
+
+// Runs in the rtos timer thread every period
+fn tick(arg: ?*anyopaque) callconv(.C) void {
+    _ = arg;
+    // gpio.write(led, on);
+    on = !on;
+    uart.write(.uart1, if (on) "zick\r\n" else "zock\r\n");
+}
+
+// Called from main before the rtos is started
 export fn zig_main() void {
     // const led: u16 = comptime p.Bank.C.pin(13);
     // _ = comptime p.Bank.bankFromPin(led);
@@ -15,20 +30,9 @@ export fn zig_main() void {
 
     // c.systick_init(c.CLOCK_FREQ / 1000);
 
-    var timer: u32 = 0;
-    const period: u32 = 250;
     // uart.init(.uart1, 9600);
-    var on: bool = true;
     uart.write(.uart1, "Booting\r\n");
 
-    while (true) {
-        if (c.systick_timer_expired(&timer, period, c.systick_get_ticks())) {
-            // gpio.write(led, on);
-            on = !on;
-            uart.write(.uart1, if (on) "zick\r\n" else "zock\r\n");
-        }
-        c.rtos_delay(1);
-    }
-
-    while (true) {}
+    c.rtos_timer_init(&zig_timer, &tick, null);
+    c.rtos_timer_start(&zig_timer, period, period);
 }
@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""Download the rtos trace buffer over the spacepacket link and print it as a timeline.
+
+    trace_decode.py --port /dev/ttyUSB0 [--save trace.bin]
+    trace_decode.py --load trace.bin
+
+Threads are identified by their creation order (the idle thread is 0), name them with
+--threads idle,timer,work,packet. Needs pyserial to download.
+"""
+
+import argparse
+import struct
+import sys
+
+KISS_FEND = 0xC0
+KISS_FESC = 0xDB
+KISS_TFEND = 0xDC
+KISS_TFESC = 0xDD
+
+TRACE_APID = 4
+TRACE_CMD_STOP = 0
+TRACE_CMD_START = 1
+TRACE_CMD_READ = 2
+
+RTOS_TRACE_SIZE = 512
+RTOS_TRACE_NO_THREAD = 0xFF
+
+# Must match rtos_trace_event_t (inc/rtos/trace.h)
+EVENTS = [
+    "SWITCH",
+    "READY",
+    "ISR_ENTER",
+    "ISR_EXIT",
+    "DELAY",
+    "SEM_TAKE",
+    "SEM_BLOCK",
+    "SEM_TIMEOUT",
+    "SEM_GIVE",
+    "DEADLINE_MISS",
+]
+
+RECORD = struct.Struct(">IBBH")
+
+
+def kiss_pack(data):
+    out = bytearray()
+    for byte in data:
+        if byte == KISS_FEND:
+            out += bytes([KISS_FESC, KISS_TFEND])
+        elif byte == KISS_FESC:
+            out += bytes([KISS_FESC, KISS_TFESC])
+        else:
+            out.append(byte)
+    out.append(KISS_FEND)
+    return bytes(out)
+
+
+def kiss_unpack(data):
+    out = bytearray()
+    escaped = False
+    for byte in data:
+        if escaped:
+            out.append(KISS_FEND if byte == KISS_TFEND else KISS_FESC)
+            escaped = False
+        elif byte == KISS_FESC:
+            escaped = True
+        else:
+            out.append(byte)
+    return bytes(out)
+
+
+class Link:
+    """Telecommands to the trace apid, see spacepacket_process (src/app/spacepacket.c)"""
+
+    def __init__(self, port, baud, timeout, retries):
+        import serial
+
+        self.serial = serial.Serial(port, baud, timeout=timeout)
+        self.retries = retries
+        self.sequence = 0
+
+    def send(self, data):
+        self.sequence = (self.sequence + 1) & 0x3FFF
+        header = bytes([
+            (1 << 4) | ((TRACE_APID >> 8) & 0x07),  # version 0, telecommand, no secondary header
+            TRACE_APID & 0xFF,
+            (0x3 << 6) | (self.sequence >> 8),      # unsegmented
+            self.sequence & 0xFF,
+            ((len(data) - 1) >> 8) & 0xFF,
+            (len(data) - 1) & 0xFF,
+        ])
+        packet = header + data
+        packet += bytes([sum(packet) & 0xFF])
+        self.serial.write(kiss_pack(packet))
+
+    def match(self, payload):
+        """Find the response to the last request at the end of a deframed payload.
+
+        Responses are only terminated by a FEND, and uart1 also carries debug text, so the text
+        sent since the previous frame is in front of the packet. Every offset is tried as the
+        start of a telemetry packet from the trace apid that echoes the request's sequence count
+        and whose data length runs to the end of the payload.
+        """
+        for start in range(len(payload) - 7, -1, -1):
+            header = payload[start:start + 6]
+            apid = ((header[0] & 0x07) << 8) | header[1]
+            telecommand = header[0] & 0x10
+            sequence = ((header[2] & 0x3F) << 8) | header[3]
+            length = ((header[4] << 8) | header[5]) + 1
+            if (
+                apid == TRACE_APID
+                and not telecommand
+                and sequence == self.sequence
+                and start + 6 + length == len(payload)
+            ):
+                return payload[start + 6:]
+        return None
+
+    def request(self, data):
+        """Send a request and return the status and data of its response, retrying (with a new
+        sequence count, so late responses to an earlier attempt are ignored) if it is lost"""
+        for _ in range(self.retries + 1):
+            self.send(data)
+            while True:
+                frame = self.serial.read_until(bytes([KISS_FEND]))
+                if not frame.endswith(bytes([KISS_FEND])):
+                    break  # timed out, resend
+                response = self.match(kiss_unpack(frame[:-1]))
+                if response is not None:
+                    return response[0], response[1:]
+        raise IOError(f"no response after {self.retries + 1} attempts")
+
+    def download(self):
+        status, data = self.request(bytes([TRACE_CMD_STOP]))
+        if status != 0:
+            raise IOError(f"stop failed with status 0x{status:02x}")
+        (count,) = struct.unpack(">I", data[:4])
+
+        records = []
+        skipped = []
+        try:
+            for index in range(max(0, count - RTOS_TRACE_SIZE), count):
+                status, data = self.request(bytes([TRACE_CMD_READ]) + struct.pack(">I", index))
+                if status != 0:
+                    # Overwritten before the trace was stopped
+                    skipped.append((index, status))
+                    continue
+                records.append(RECORD.unpack(data[:RECORD.size]))
+        finally:
+            self.request(bytes([TRACE_CMD_START]))
+
+        for index, status in skipped:
+            print(f"skipped record {index} (status 0x{status:02x})", file=sys.stderr)
+        return records
+
+
+def thread_name(names, thread):
+    if thread == RTOS_TRACE_NO_THREAD:
+        return "-"
+    if thread < len(names):
+        return names[thread]
+    return f"thread{thread}"
+
+
+def decode(records, cpu_hz, names):
+    if not records:
+        print("no records")
+        return
+
+    # The cycle counter wraps every 2^32 cycles (~268 s at 16 MHz), accumulate the deltas
+    elapsed = 0
+    last = records[0][0]
+    ready_at = {}
+    latency_max = {}
+    for cycles, event, thread, arg in records:
+        elapsed += (cycles - last) & 0xFFFFFFFF
+        last = cycles
+        us = elapsed * 1e6 / cpu_hz
+
+        name = EVENTS[event] if event < len(EVENTS) else f"EVENT{event}"
+        who = thread_name(names, thread)
+        if name == "SWITCH":
+            detail = f"{who} -> {thread_name(names, arg)}"
+            # Ready to running latency of the thread switched in
+            if arg in ready_at:
+                latency = elapsed - ready_at.pop(arg)
+                latency_max[arg] = max(latency_max.get(arg, 0), latency)
+                detail += f"  (ready for {latency * 1e6 / cpu_hz:.1f} us)"
+        elif name == "READY":
+            ready_at.setdefault(thread, elapsed)
+            detail = f"{who} (priority {arg})"
+        elif name in ("ISR_ENTER", "ISR_EXIT"):
+            detail = f"exception {arg} in {who}"
+        elif name == "DELAY":
+            detail = f"{who} for {arg} ticks"
+        elif name == "DEADLINE_MISS":
+            detail = f"{who} responded in {arg}% of its deadline"
+        else:
+            detail = f"{who} sem 0x....{arg:04x}"
+        print(f"{us:14.1f} us  {name:<13} {detail}")
+
+    print()
+    print("worst ready to running latency:")
+    for thread, latency in sorted(latency_max.items()):
+        print(f"  {thread_name(names, thread):<12} {latency * 1e6 / cpu_hz:10.1f} us")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the spacepacket link (uart1)")
+    source.add_argument("--load", help="decode records saved with --save")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=2.0)
+    parser.add_argument("--retries", type=int, default=3, help="resends of a lost request")
+    parser.add_argument("--save", help="save the downloaded records to a file")
+    parser.add_argument("--cpu-hz", type=float, default=16e6, help="DWT cycle counter rate")
+    parser.add_argument("--threads", default="idle", help="comma separated thread names")
+    args = parser.parse_args()
+
+    if args.load:
+        with open(args.load, "rb") as f:
+            raw = f.read()
+        records = [RECORD.unpack_from(raw, i) for i in range(0, len(raw), RECORD.size)]
+    else:
+        records = Link(args.port, args.baud, args.timeout, args.retries).download()
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(b"".join(RECORD.pack(*r) for r in records))
+
+    decode(records, args.cpu_hz, args.threads.split(","))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())